@@ -81,6 +81,11 @@ static inline std::string py_stats_dump(const stats &)
     return stats::dump();
 }
 
+static inline settings::MultiplicationThresholds py_get_multiplication_thresholds()
+{
+    return settings::getMultiplicationThresholds();
+}
+
 // Instantiate the pyranha Core module.
 BOOST_PYTHON_MODULE(_Core)
 {   
@@ -134,6 +139,18 @@ BOOST_PYTHON_MODULE(_Core)
     class_setm.add_static_property("max_pretty_print_size",        &settings::get_max_pretty_print_size, &settings::set_max_pretty_print_size);
     class_setm.add_static_property("nthread",                      &settings::get_nthread,&settings::set_nthread);
     class_setm.add_static_property("multiplication_algorithm",     &settings::getMultiplicationAlgorithm, &settings::setMultiplicationAlgorithm);
+    class_setm.add_static_property("power_algorithm",              &settings::getPowerAlgorithm, &settings::setPowerAlgorithm);
+    class_setm.def("get_cache_size", &settings::get_cache_size, "Size in kilobytes of the data cache of the given level (1, 2 or 3).")
+    .staticmethod("get_cache_size");
+    class_setm.def("set_cache_size", &settings::set_cache_size, "Override the size in kilobytes of the data cache of the given level.")
+    .staticmethod("set_cache_size");
+    class_setm.def("detect_cache_sizes", &settings::detect_cache_sizes, "Detect the cache sizes of the host, discarding the overrides.")
+    .staticmethod("detect_cache_sizes");
+    class_setm.add_static_property("multiplication_thresholds",    &py_get_multiplication_thresholds, &settings::setMultiplicationThresholds);
+    class_setm.def("load_multiplication_profile", &settings::loadMultiplicationProfile, "Load the multiplication thresholds from a profile file.")
+    .staticmethod("load_multiplication_profile");
+    class_setm.def("save_multiplication_profile", &settings::saveMultiplicationProfile, "Save the multiplication thresholds into a profile file.")
+    .staticmethod("save_multiplication_profile");
 
 
     enum_<settings::MultiplicationAlgorithm>("multiplication_algorithm")
@@ -141,9 +158,25 @@ BOOST_PYTHON_MODULE(_Core)
     .value("plain",        settings::MultiplicationAlgorithm::PLAIN)
     .value("vector_coded", settings::MultiplicationAlgorithm::VECTOR_CODED)
     .value("hash_coded",   settings::MultiplicationAlgorithm::HASH_CODED)
+    .value("heap_coded",   settings::MultiplicationAlgorithm::HEAP_CODED)
+    .value("fft",          settings::MultiplicationAlgorithm::FFT)
     .export_values();
 
 
+    enum_<settings::PowerAlgorithm>("power_algorithm")
+    .value("automatic", settings::PowerAlgorithm::AUTOMATIC)
+    .value("binomial",  settings::PowerAlgorithm::BINOMIAL)
+    .value("miller",    settings::PowerAlgorithm::MILLER);
+
+
+    class_<settings::MultiplicationThresholds>("multiplication_thresholds", "Thresholds of the automatic selection of the multiplication algorithm.")
+    .def_readwrite("plain_coded",    &settings::MultiplicationThresholds::plainCoded)
+    .def_readwrite("sparse_density", &settings::MultiplicationThresholds::sparseDensity)
+    .def_readwrite("threaded_coded", &settings::MultiplicationThresholds::threadedCoded)
+    .def_readwrite("threaded_plain", &settings::MultiplicationThresholds::threadedPlain)
+    .def_readwrite("fft_cost",       &settings::MultiplicationThresholds::fftCost);
+
+
     // psym.
     class_<Psym>("psym", "Symbol class.", init<const std::string &, const std::vector<double> &>())
     .def(init<const std::string &, const double &>())
@@ -18,11 +18,14 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <boost/python/args.hpp>
 #include <boost/python/class.hpp>
+#include <boost/python/def.hpp>
 #include <boost/python/module.hpp>
 #include <boost/python/docstring_options.hpp>
 #include <string>
 
+#include "../../src/core/multiplication_calibration.h"
 #include "../../src/manipulators/dpoly.h"
 #include "../series_instantiations.h"
 #include "../exceptions.h"
@@ -47,4 +50,8 @@ BOOST_PYTHON_MODULE(_Dpoly)
     series_complex_instantiation(instc, inst);
     series_sub_instantiation<dpolyc, dpolyc>(instc);
     series_sub_instantiation<dpolyc, dpoly>(instc);
+
+    def("calibrate_multiplication", &calibrateMultiplication<dpoly>, (arg("profile") = std::string(), arg("quick") = false),
+        "Benchmark the multiplication algorithms on dpoly, set the tuned thresholds and save them into the given profile file, if any. "
+        "A quick calibration is less accurate.");
 }
@@ -66,6 +66,7 @@ BOOST_PYTHON_MODULE(_Truncators)
     class_<truncators::Norm>("__norm_truncator", "Norm truncator.", init<>())
     .def("__repr__", &py_print_to_string<truncators::Norm>)
     .def("set", &truncators::Norm::set, "Set norm truncation level to arg1.").staticmethod("set")
+    .def("set_pairwise", &truncators::Norm::setPairwise, "Discard the products of terms whose norm is below arg1.").staticmethod("set_pairwise")
     .def("unset", &truncators::Norm::unset, "Disable norm-based truncation.").staticmethod("unset");
 
     def("unset",&truncators::unset,"Unset all truncators.");
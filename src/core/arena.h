@@ -0,0 +1,246 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_ARENA_H
+#define PIRANHA_ARENA_H
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "config.h"
+#include "exceptions.h"
+#include "memory.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace piranha
+{
+	/// Arena of memory for temporaries.
+	/**
+	 * Memory is handed out by bumping a pointer through large chunks, and all of it is given back in one step
+	 * by release() or by the destructor. The chunks are obtained from piranha::CountingAllocator, hence they
+	 * take part in the memory accounting and in the memory limit. Single deallocations only give back the most
+	 * recent allocation, which is what growing containers do.
+	 *
+	 * An arena is owned by a scope, e.g., a multiplication, and must outlive everything allocated from it.
+	 * Allocations are serialised by a mutex, so that containers used by different threads can share an arena.
+	 */
+	class Arena
+	{
+			typedef CountingAllocator<char> ChunkAllocator;
+			typedef std::allocator_traits<ChunkAllocator> ChunkTraits;
+
+			struct Chunk
+			{
+				char		*data;
+				std::size_t	size;
+			};
+
+		public:
+
+			/// Default size of the chunks.
+			static const std::size_t defaultChunkSize = 1u << 20;
+
+			/// Constructor. No memory is allocated until the first allocation.
+			explicit Arena(std::size_t const chunkSize = defaultChunkSize): m_chunkSize(chunkSize), m_top(0), m_end(0), m_last(0)
+			{
+				PIRANHA_ASSERT(chunkSize > 0);
+			}
+
+
+			Arena(Arena const &) = delete;
+			Arena &operator=(Arena const &) = delete;
+
+
+			~Arena()
+			{
+				release();
+			}
+
+
+			/// Allocate n bytes aligned to alignment, which must be a power of two.
+			void *allocate(std::size_t const n, std::size_t const alignment)
+			{
+				PIRANHA_ASSERT(alignment && !(alignment & (alignment - 1)));
+				boost::lock_guard<boost::mutex> lock(m_mutex);
+				char *retval = align(m_top, alignment);
+				// Aligning may move past the end of the chunk, when its size is not a multiple of the alignment.
+				if (!m_top || retval > m_end || n > std::size_t(m_end - retval))
+				{
+					// Requests above half a chunk get a chunk of their own, so that the current one is not wasted.
+					if (n + alignment > m_chunkSize / 2)
+					{
+						return align(newChunk(n + alignment), alignment);
+					}
+					m_top  = newChunk(m_chunkSize);
+					m_end  = m_top + m_chunkSize;
+					retval = align(m_top, alignment);
+				}
+				m_last = retval;
+				m_top  = retval + n;
+				return retval;
+			}
+
+
+			/// Deallocate n bytes at p. Only the most recent allocation is actually given back to the arena.
+			void deallocate(void *const p, std::size_t const n)
+			{
+				boost::lock_guard<boost::mutex> lock(m_mutex);
+				if (p && p == m_last && static_cast<char *>(p) + n == m_top)
+				{
+					m_top  = m_last;
+					m_last = 0;
+				}
+			}
+
+
+			/// Give back all the memory of the arena.
+			/**
+			 * Everything allocated from the arena becomes invalid.
+			 */
+			void release()
+			{
+				boost::lock_guard<boost::mutex> lock(m_mutex);
+				ChunkAllocator allocator;
+				for (std::size_t i = 0; i < m_chunks.size(); ++i)
+				{
+					ChunkTraits::deallocate(allocator, m_chunks[i].data, m_chunks[i].size);
+				}
+				m_chunks.clear();
+				m_top  = 0;
+				m_end  = 0;
+				m_last = 0;
+			}
+
+
+			/// Number of bytes obtained from piranha::CountingAllocator.
+			std::size_t size() const
+			{
+				boost::lock_guard<boost::mutex> lock(m_mutex);
+				std::size_t retval = 0;
+				for (std::size_t i = 0; i < m_chunks.size(); ++i)
+				{
+					retval += m_chunks[i].size;
+				}
+				return retval;
+			}
+
+		private:
+
+			static char *align(char *const p, std::size_t const alignment)
+			{
+				const std::uintptr_t n = reinterpret_cast<std::uintptr_t>(p);
+				return p + ((alignment - n % alignment) % alignment);
+			}
+
+
+			// New chunk of n bytes, appended to the list.
+			char *newChunk(std::size_t const n)
+			{
+				ChunkAllocator allocator;
+				m_chunks.reserve(m_chunks.size() + 1);
+				char *const retval = ChunkTraits::allocate(allocator, n);
+				m_chunks.push_back(Chunk{retval, n});
+				return retval;
+			}
+
+		private:
+
+			std::size_t				m_chunkSize;
+			std::vector<Chunk>		m_chunks;
+			// Free space of the current chunk.
+			char					*m_top;
+			char					*m_end;
+			// Most recent allocation, if it can still be given back.
+			char					*m_last;
+			mutable boost::mutex	m_mutex;
+	};
+
+
+	/// STL-compatible allocator drawing memory from a piranha::Arena.
+	/**
+	 * A default constructed allocator, which has no arena, falls back to piranha::CountingAllocator. Containers can then keep
+	 * working whether or not a scope provides them an arena. Allocators compare equal if they use the same arena.
+	 */
+	template <class T>
+	class ArenaAllocator
+	{
+			template <class U>
+			friend class ArenaAllocator;
+
+		public:
+
+			typedef T				value_type;
+			typedef std::size_t		size_type;
+			typedef std::ptrdiff_t	difference_type;
+
+			ArenaAllocator(): m_arena(0) {}
+
+			explicit ArenaAllocator(Arena &arena): m_arena(&arena) {}
+
+			template <class U>
+			ArenaAllocator(ArenaAllocator<U> const &other): m_arena(other.m_arena) {}
+
+
+			[[nodiscard]] T *allocate(size_type const n)
+			{
+				if (!m_arena)
+				{
+					return CountingAllocator<T>().allocate(n);
+				}
+				return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+			}
+
+
+			void deallocate(T *const p, size_type const n)
+			{
+				if (!m_arena)
+				{
+					CountingAllocator<T>().deallocate(p, n);
+				} else
+				{
+					m_arena->deallocate(p, n * sizeof(T));
+				}
+			}
+
+
+			template <class U>
+			bool operator==(ArenaAllocator<U> const &other) const
+			{
+				return m_arena == other.m_arena;
+			}
+
+
+			template <class U>
+			bool operator!=(ArenaAllocator<U> const &other) const
+			{
+				return m_arena != other.m_arena;
+			}
+
+		private:
+
+			Arena	*m_arena;
+	};
+}
+
+#endif
@@ -24,23 +24,108 @@
 #include "../config.h"
 
 #include <atomic>
+#include <cstddef>
 
 namespace piranha
 {
 	class PIRANHA_VISIBLE BaseCountingAllocator   //this way all classes derived from this one share the counter
 	{
-	public:
-		using CounterType = std::atomic_size_t;
-	
-	
-		static CounterType::value_type count() noexcept
-		{
-			return counter;
-		}
-	protected:
+			friend class ThreadMemoryCounter;
+
+		public:
+			// Signed: the balance of a thread that frees memory allocated by other threads is negative.
+			using CounterType = std::atomic<std::ptrdiff_t>;
+
+
+			/// Bytes counted by all the threads, up to the balances not yet added by piranha::ThreadMemoryCounter.
+			static std::size_t count() noexcept
+			{
+				const std::ptrdiff_t retval = counter.load(std::memory_order_relaxed);
+				return retval > 0 ? static_cast<std::size_t>(retval) : 0;
+			}
+
+		protected:
 
 			static inline CounterType counter = 0;
 	};
+
+
+	/// Memory counter of the calling thread.
+	/**
+	 * Allocations and deallocations are accumulated into a balance private to each thread, which is added to the shared counter
+	 * of piranha::BaseCountingAllocator only when it exceeds batchSize bytes in either direction, when the thread finishes a job of
+	 * a multi-threaded multiplication and when it exits. Hence concurrent allocations do not bounce the cache line of the shared counter,
+	 * and the shared counter is accurate up to batchSize bytes per thread.
+	 */
+	class ThreadMemoryCounter
+	{
+		public:
+
+			/// Largest balance kept by a thread, in bytes.
+			static const std::ptrdiff_t batchSize = std::ptrdiff_t(1) << 18;
+
+
+			/// Count n allocated bytes. Returns true if the balance is due to be added to the shared counter through flush().
+			static bool add(std::size_t const n)
+			{
+				std::ptrdiff_t &balance = local().m_balance;
+				balance += static_cast<std::ptrdiff_t>(n);
+				return balance >= batchSize;
+			}
+
+
+			/// Count n deallocated bytes.
+			static void subtract(std::size_t const n)
+			{
+				std::ptrdiff_t &balance = local().m_balance;
+				balance -= static_cast<std::ptrdiff_t>(n);
+				if (balance <= -batchSize)
+				{
+					flush();
+				}
+			}
+
+
+			/// Add the balance of the calling thread to the shared counter.
+			static void flush()
+			{
+				ThreadMemoryCounter &c = local();
+				if (c.m_balance)
+				{
+					BaseCountingAllocator::counter.fetch_add(c.m_balance, std::memory_order_relaxed);
+					c.m_balance = 0;
+				}
+			}
+
+
+			/// Bytes counted by all the threads, including the balance of the calling thread.
+			static std::size_t total() noexcept
+			{
+				const std::ptrdiff_t retval = BaseCountingAllocator::counter.load(std::memory_order_relaxed) + local().m_balance;
+				return retval > 0 ? static_cast<std::size_t>(retval) : 0;
+			}
+
+		private:
+
+			ThreadMemoryCounter(): m_balance(0) {}
+
+
+			~ThreadMemoryCounter()
+			{
+				BaseCountingAllocator::counter.fetch_add(m_balance, std::memory_order_relaxed);
+			}
+
+
+			static ThreadMemoryCounter &local() noexcept
+			{
+				thread_local ThreadMemoryCounter c;
+				return c;
+			}
+
+		private:
+
+			std::ptrdiff_t	m_balance;
+	};
 }
 
 #endif
@@ -24,6 +24,7 @@
 
 #include "../config.h"
 #include "../exceptions.h"
+#include "../flat_hash_set.h"
 #include "../memory.h"
 #include "../mp.h"
 #include "../Psym.h"
@@ -67,12 +68,19 @@ namespace piranha
 	
 
 	// Struct to define the container used in series - like a template typedef.
+	//
+	// Terms are stored inline in a flat open addressing hash set. Defining PIRANHA_NODE_SERIES_CONTAINER at build time
+	// selects the node based boost::unordered_set used before, e.g., for comparison.
 	template <class Term>
 	struct SeriesContainer
 	{
+#ifdef PIRANHA_NODE_SERIES_CONTAINER
 		//typedef std::unordered_set<Term> Type;
 		typedef boost::unordered_set<Term, boost::hash<Term>, std::equal_to<Term>, CountingAllocator<Term> > Type;
 		//using Type = std::unordered_set<Term, Hasher<Term>, std::equal_to<Term>, CountingAllocator<Term> >;
+#else
+		typedef FlatHashSet<Term, boost::hash<Term>, std::equal_to<Term>, CountingAllocator<Term> > Type;
+#endif
 	};
 
 
@@ -139,6 +147,9 @@ namespace piranha
 			template <typename>
 			friend struct BaseSeriesEqualToSelector;
 
+			template <class, class, class, class>
+			friend class CodedMultiplier;
+
 
 
 		public:
@@ -148,7 +159,7 @@ namespace piranha
 
 			// Term container.
 			//
-			// The underlying term container is a plain boost::unordered set. Term types must specialise the boost::hash class, which
+			// The underlying term container is a hash set (see SeriesContainer). Term types must specialise the boost::hash class, which
 			// will be used to provide the hash values for terms.
 			//
 			typedef typename SeriesContainer<TermType>::Type ContainerType;
@@ -197,6 +208,12 @@ namespace piranha
 			template <class ArgsTuple>
 			void baseConstructFromPsym(const Psym &, const int, const ArgsTuple &);
 
+			BaseSeries() = default;
+			BaseSeries(const BaseSeries &) = default;
+			// Moving a series moves its container, so that terms whose coefficients are series relocate cheaply.
+			BaseSeries(BaseSeries &&) = default;
+			BaseSeries &operator=(const BaseSeries &) = default;
+			BaseSeries &operator=(BaseSeries &&) = default;
 			~BaseSeries();
 			//
 
@@ -388,6 +405,19 @@ namespace piranha
 				}
 			};
 
+		protected:
+			// @name Bulk construction.
+			//
+			// Used by the multipliers to build their result out of terms known to be unique, canonical, not ignorable
+			// and with the series' number of arguments (e.g., the decoded results of coded multiplication). No duplicate
+			// lookup is performed before insertion.
+			//defined: base_series_manip.h
+			void reserveTerms(const size_type);
+
+			template <class ArgsTuple>
+			void insertUnique(const TermType &, const ArgsTuple &);
+			//
+
 		private:
 
 			template <class T, class ArgsTuple>
@@ -156,6 +156,36 @@ namespace piranha
 	}
 
 
+	// Prepare the term container for holding n terms, so that it is rehashed at most once during bulk construction.
+	template <PIRANHA_BASE_SERIES_TP_DECL>
+	inline void BaseSeries<PIRANHA_BASE_SERIES_TP>::reserveTerms(const size_type n)
+	{
+		container.reserve(n);
+	}
+
+
+	// Insert a term known not to be in the series.
+	//
+	// Unlike insert(), no conversion, padding, canonicalisation, ignorability check or duplicate lookup
+	// is performed: all these conditions are only asserted.
+	template <PIRANHA_BASE_SERIES_TP_DECL>
+	template <class ArgsTuple>
+	inline void BaseSeries<PIRANHA_BASE_SERIES_TP>::insertUnique(const TermType &term, const ArgsTuple &argsTuple)
+	{
+		PIRANHA_ASSERT(!term.cf.isIgnorable(argsTuple) && !term.key.isIgnorable(argsTuple));
+		PIRANHA_ASSERT(term.cf.isInsertable(argsTuple) && term.key.isInsertable(argsTuple) &&
+			          !term.cf.needsPadding(argsTuple) && !term.key.needsPadding(argsTuple) && term.isCanonical(argsTuple));
+		PIRANHA_ASSERT(findTerm(term) == end());
+		(void)argsTuple;
+
+#ifdef PIRANHA_NODE_SERIES_CONTAINER
+		container.insert(term);
+#else
+		container.insertUnique(term);
+#endif
+	}
+
+
 	template <PIRANHA_BASE_SERIES_TP_DECL>
 	inline typename BaseSeries<PIRANHA_BASE_SERIES_TP>::const_iterator
 	BaseSeries<PIRANHA_BASE_SERIES_TP>::findTerm(const TermType &term) const
@@ -24,9 +24,11 @@
 
 #include "../config.h"
 #include "../exceptions.h"
+#include "../lambdas.h"
 #include "../math.h"
 #include "../mp.h"
 #include "../settings.h"
+#include "../stats.h"
 #include "../type_traits.h"
 #include "base_series_def.h"
 #include "base_series_mp.h"
@@ -35,6 +37,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/type_traits/is_complex.hpp>
 
+#include <algorithm>
 #include <cstddef>
 #include <complex>
 #include <string>
@@ -499,71 +502,48 @@ namespace piranha
 
 	// Exponentiation to natural number.
 	//
-	// Exponentiation by squaring is used internally.
+	// Left-to-right exponentiation by squaring: the bits of n are scanned from the most significant one, the result
+	// is squared at each bit and multiplied by the base when the bit is set. The squarings multiply a series by itself,
+	// so that the coded multipliers can take advantage of the symmetry of the product, and the other multiplications
+	// involve the base, which is usually the shortest series. Each product goes through the active truncator, hence
+	// the intermediate results never hold terms that the final truncation would discard. The lengths of the
+	// intermediate results are traced through stats.
 	//
 	template <PIRANHA_BASE_SERIES_TP_DECL>
 	template <class ArgsTuple>
 	inline Derived BaseSeries<PIRANHA_BASE_SERIES_TP>::naturalPower(const std::size_t n, const ArgsTuple &argsTuple) const
 	{
 		Derived retval;
-		switch (n) {
-		case 0: {
+		if (n == 0)
+		{
 			retval.baseAdd(1, argsTuple);
-			break;
-		    }
-
-		case 1: {
-			retval = *derived_const_cast;
-			break;
-		    }
-
-		case 2: {
-			retval = *derived_const_cast;
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			break;
-		    }
-
-		case 3: {
-			retval = *derived_const_cast;
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			break;
-		    }
-
-		case 4: {
-			retval = *derived_const_cast;
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			retval.baseMultBy(*derived_const_cast, argsTuple);
-			break;
+			return retval;
 		}
 
-		default: {
-			retval.baseAdd(1, argsTuple);
-			// Use scoping here to have tmp destroyed when it is not needed anymore.
+		retval = *derived_const_cast;
+		std::size_t bit = 1;
+		while (bit <= n / 2)
+		{
+			bit <<= 1;
+		}
+
+		// Once the truncator has discarded all the terms, the result stays empty.
+		for (bit >>= 1; bit != 0 && !retval.empty(); bit >>= 1)
+		{
+			retval.baseMultBy(retval, argsTuple);
+			stats::trace_stat("pow: squarings", std::size_t(0), increment);
+			if (n & bit)
 			{
-			    Derived tmp(*derived_const_cast);
-			    std::size_t i = n;
-			    while (i)
-                {
-				    if (i & 1) 
-                    {
-					    retval.baseMultBy(tmp, argsTuple);
-					    --i;
-				    }
-
-				    i /= 2;
-				    if (i != 0) 
-                    {
-					    tmp.baseMultBy(tmp, argsTuple);
-				    }
-			    }
+				retval.baseMultBy(*derived_const_cast, argsTuple);
 			}
+
+			const std::size_t length = retval.length();
+			stats::trace_stat("pow: intermediate terms", std::size_t(0), [length](const std::size_t x) -> std::size_t { return x + length; });
+			stats::trace_stat("pow: peak terms", std::size_t(0), [length](const std::size_t x) -> std::size_t { return std::max(x, length); });
 		}
-	}
 
-	return retval;
-    }
+		return retval;
+	}
 
 
 	/// Nth root.
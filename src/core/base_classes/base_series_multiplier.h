@@ -29,15 +29,16 @@
 #include "../settings.h"
 #include "../stats.h"
 #include "../lambdas.h"
+#include "../thread_pool.h"
 #include "base_series_multiplier_mp.h"
 #include "null_truncator.h"
 
 #include <boost/numeric/conversion/cast.hpp>
-#include <boost/thread/thread.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/lambda/lambda.hpp>
 
 #include <algorithm>
+#include <array>
 #include <functional>
 #include <cmath>
 #include <cstddef>
@@ -65,94 +66,183 @@ namespace piranha
 
 			// Compute block size for multiplication.
 			/**
-			 * Resulting block size depends on the cache memory available, and will always be in the [16,8192] range. N is
+			 * Resulting block size depends on the size of the data cache of the given level, and will always be in the [16,8192] range. N is
 			 * the size of the base storage unit type used to store the result of the multiplication (e.g., coefficient type in vector coded, coded hash table
 			 * term in the sparse hashed multiplication, etc.).
 			 */
 			template <std::size_t N> requires(N > 0)
-			static std::size_t computeBlockSize()
+			static std::size_t computeBlockSize(unsigned const level = 2)
 			{
 				// NOTE: this function is used typically considering only the output storage requirements, since storage of input series
 				//       will be a small fraction of storage for the output series.
 
 				const std::size_t shift = boost::numeric_cast<std::size_t>(
-					        std::log(std::max<double>(16., std::sqrt(static_cast<double>((settings::cache_size * 1024) / N)))) / std::log(2.) - 1
+					        std::log(std::max<double>(16., std::sqrt(static_cast<double>((settings::get_cache_size(level) * 1024) / N)))) / std::log(2.) - 1
 				);
 
 				return (std::size_t(2) << std::min<std::size_t>(std::size_t(12), shift));
 			}
 
 
+			// Block sizes of multi-level blocked multiplication, one per cache level, innermost first.
+			typedef std::array<std::size_t, settings::cacheLevels> BlockSizes;
+
+
+			// Compute the block sizes for multi-level blocked multiplication.
+			/**
+			 * Blocks of each level are sized after the corresponding cache level. Since block sizes are powers of two,
+			 * each block is made of whole blocks of the level below.
+			 */
+			template <std::size_t N> requires(N > 0)
+			static BlockSizes computeBlockSizes()
+			{
+				BlockSizes retval;
+				for (unsigned i = 0; i < settings::cacheLevels; ++i)
+				{
+					retval[i] = computeBlockSize<N>(i + 1);
+					if (i > 0)
+					{
+						retval[i] = std::max(retval[i], retval[i - 1]);
+					}
+				}
+
+				return retval;
+			}
+
+
+			// Multi-level blocked multiplication.
+			/**
+			 * The outermost blocks are visited row-wise, and each one is in turn split into the blocks of the level below.
+			 * Within the innermost blocks, a false return value of the functor ends the current row.
+			 */
 			template <class MulitplicationFunctor>
-			static void blockedMultiplication(std::size_t const blockSize, std::size_t const size1, std::size_t const size2, MulitplicationFunctor &m)
+			static void blockedMultiplication(BlockSizes const &blockSizes, std::size_t const size1, std::size_t const size2, MulitplicationFunctor &m)
 			{
-				PIRANHA_ASSERT(blockSize > 0);
+				blockedMultiplication(blockSizes, std::vector<std::size_t>(size1, size2), m);
+			}
 
-				const std::size_t nblocks1 = size1 / blockSize;
-                const std::size_t nblocks2 = size2 / blockSize;
 
-				for (std::size_t n1 = 0; n1 < nblocks1; ++n1)
-                {
-					const std::size_t iStart = n1 * blockSize; 
-                    const std::size_t iEnd   = iStart + blockSize;
+			// Multi-level blocked multiplication with per-row ends.
+			/**
+			 * Row i is visited up to column rowEnds[i] excluded (see computeRowEnds()). Blocks lying entirely past
+			 * the ends of their rows are skipped altogether.
+			 */
+			template <class MulitplicationFunctor>
+			static void blockedMultiplication(BlockSizes const &blockSizes, std::vector<std::size_t> const &rowEnds, MulitplicationFunctor &m)
+			{
+				const std::size_t size2 = rowEnds.empty() ? 0 : *std::max_element(rowEnds.begin(), rowEnds.end());
+				blockedMultiplication(blockSizes, settings::cacheLevels - 1, 0, rowEnds.size(), 0, size2, false, rowEnds, m);
+			}
 
-					// regulars1 * regulars2
-					for (std::size_t n2 = 0; n2 < nblocks2; ++n2)
-                    {
-						const std::size_t jStart = n2 * blockSize; 
-                        const std::size_t jEnd   = jStart + blockSize;
 
-						for (std::size_t i = iStart; i < iEnd; ++i)
-                        {
-							for (std::size_t j = jStart; j < jEnd; ++j)
-                            {
-								if (!m(i, j))
-                                {
-									break;
-								}
-							}
-						}
-					}
+			// Multi-level blocked squaring.
+			/**
+			 * Same as blockedMultiplication(), but only the pairs (i, j) with j >= i are visited. Blocks lying
+			 * entirely below the diagonal are skipped altogether.
+			 */
+			template <class MulitplicationFunctor>
+			static void blockedSquaring(BlockSizes const &blockSizes, std::size_t const size, MulitplicationFunctor &m)
+			{
+				blockedSquaring(blockSizes, std::vector<std::size_t>(size, size), m);
+			}
 
-					// regulars1 * rem2
-					for (std::size_t i = iStart; i < iEnd; ++i)
-                    {
-						for (std::size_t j = nblocks2 * blockSize; j < size2; ++j)
-                        {
-							if (!m(i, j))
-                            {
-								break;
-							}
+
+			template <class MulitplicationFunctor>
+			static void blockedSquaring(BlockSizes const &blockSizes, std::vector<std::size_t> const &rowEnds, MulitplicationFunctor &m)
+			{
+				blockedMultiplication(blockSizes, settings::cacheLevels - 1, 0, rowEnds.size(), 0, rowEnds.size(), true, rowEnds, m);
+			}
+
+
+			// Ends of the rows of a multiplication under truncation.
+			/**
+			 * The truncators sort the input terms (e.g., by increasing degree), so that along each row the pairs skipped
+			 * by the truncator come after the others. Then the end of each row, i.e., its first skipped pair, is located
+			 * by binary search, and the truncated pairs need not be visited at all. Without truncation all the rows end
+			 * at terms2.size().
+			 */
+			template <class GenericTruncator>
+			static std::vector<std::size_t> computeRowEnds(std::vector<TermType1 const *> &terms1, std::vector<TermType2 const *> &terms2,
+			                                               GenericTruncator const &truncator)
+			{
+				std::vector<std::size_t> retval(terms1.size(), terms2.size());
+				if (!truncator.isEffective())
+				{
+					return retval;
+				}
+
+				for (std::size_t i = 0; i < terms1.size(); ++i)
+				{
+					std::size_t first = 0, last = terms2.size();
+					while (first < last)
+					{
+						const std::size_t middle = first + (last - first) / 2;
+						if (truncator.skip(&terms1[i], &terms2[middle]))
+						{
+							last = middle;
+						} else
+						{
+							first = middle + 1;
 						}
 					}
+					retval[i] = first;
 				}
 
-				// rem1 * regulars2
-				for (std::size_t n2 = 0; n2 < nblocks2; ++n2)
-                {
-					const std::size_t jStart = n2 * blockSize; 
-                    const std::size_t jEnd   = jStart + blockSize;
+				return retval;
+			}
 
-					for (std::size_t i = nblocks1 * blockSize; i < size1; ++i)
-                    {
-						for (std::size_t j = jStart; j < jEnd; ++j)
-                        {
-							if (!m(i, j))
-                            {
-								break;
-							}
-						}
-					}
+
+			// Number of pairs of terms visited under the given row ends, i.e., the size of a multiplication under truncation.
+			static double countPairs(std::vector<std::size_t> const &rowEnds)
+			{
+				double retval = 0;
+				for (std::size_t i = 0; i < rowEnds.size(); ++i)
+				{
+					retval += double(rowEnds[i]);
 				}
 
-				// rem1 * rem2.
-				for (std::size_t i = nblocks1 * blockSize; i < size1; ++i)
-                {
-					for (std::size_t j = nblocks2 * blockSize; j < size2; ++j)
-                    {
-						if (!m(i, j))
-                        {
-							break;
+				return retval;
+			}
+
+
+			template <class MulitplicationFunctor>
+			static void blockedMultiplication(BlockSizes const &blockSizes, unsigned const level, std::size_t const iBegin, std::size_t const iEnd,
+			                                  std::size_t const jBegin, std::size_t const jEnd, bool const upper, std::vector<std::size_t> const &rowEnds,
+			                                  MulitplicationFunctor &m)
+			{
+				const std::size_t blockSize = blockSizes[level];
+				PIRANHA_ASSERT(blockSize > 0);
+
+				for (std::size_t iStart = iBegin; iStart < iEnd; iStart += blockSize)
+				{
+					const std::size_t iStop   = std::min(iStart + blockSize, iEnd);
+					const std::size_t rowsEnd = *std::max_element(rowEnds.begin() + iStart, rowEnds.begin() + iStop);
+
+					for (std::size_t jStart = jBegin; jStart < std::min(jEnd, rowsEnd); jStart += blockSize)
+					{
+						const std::size_t jStop = std::min(jStart + blockSize, jEnd);
+
+						if (upper && jStop <= iStart)
+						{
+							continue;
+						}
+
+						if (level > 0)
+						{
+							blockedMultiplication(blockSizes, level - 1, iStart, iStop, jStart, jStop, upper, rowEnds, m);
+							continue;
+						}
+
+						for (std::size_t i = iStart; i < iStop; ++i)
+						{
+							const std::size_t rowStop = std::min(jStop, rowEnds[i]);
+							for (std::size_t j = upper ? std::max(jStart, i) : jStart; j < rowStop; ++j)
+							{
+								if (!m(i, j))
+								{
+									break;
+								}
+							}
 						}
 					}
 				}
@@ -223,16 +313,19 @@ namespace piranha
 
 			struct PlainWorker {
 
+				// The thresholds in effect are captured in the launching thread, since an override is not seen by the pool threads.
 				PlainWorker(BaseSeriesMultiplier &multiplier, Series1 &retval)
-                    : multiplier(multiplier), retval(retval), terms1(multiplier.terms1)
+                    : multiplier(multiplier), retval(retval), terms1(multiplier.terms1), thresholds(settings::getMultiplicationThresholds())
 				{}
 
 				PlainWorker(BaseSeriesMultiplier &multiplier, Series1 &retval, std::vector<std::vector<TermType1 const *> > &split1, const std::size_t idx)
-                    : multiplier(multiplier), retval(retval), terms1(split1[idx])
+                    : multiplier(multiplier), retval(retval), terms1(split1[idx]), thresholds(settings::getMultiplicationThresholds())
 				{}
 
 				void operator()()
 				{
+					// Coefficients may be series themselves, whose multiplications must see the same thresholds.
+					const settings::MultiplicationThresholdsOverride thresholdsOverride(thresholds);
 					// Build the truncator.
 					const typename Truncator::template GetType<Series1, Series2, ArgsTuple> truncator(terms1, multiplier.terms2, multiplier.argsTuple);
 					// Use the selected truncator only if it really truncates, otherwise use the
@@ -245,6 +338,8 @@ namespace piranha
                     {
 						plainImplementation(NullTruncator::template GetType<Series1, Series2, ArgsTuple>(terms1, multiplier.terms2, multiplier.argsTuple) );
 					}
+					// Pool threads outlive the multiplication: count their memory now.
+					ThreadMemoryCounter::flush();
 				}
 
 
@@ -253,23 +348,21 @@ namespace piranha
 				{
 					typedef typename TermType1::multiplication_result ResultType;
 					ResultType res;
-					const std::size_t size1 = terms1.size();
-                    const std::size_t size2 = multiplier.terms2.size();
-
-					PIRANHA_ASSERT(size1 && size2);
+					PIRANHA_ASSERT(terms1.size() && multiplier.terms2.size());
 
 					const TermType1 **t1 = &terms1[0];
 					const TermType2 **t2 = &multiplier.terms2[0];
 					PlainFunctor<GenericTruncator> plainFunctor(res, t1, t2, truncator, retval, multiplier.argsTuple);
-					const std::size_t blockSize = computeBlockSize<boost::tuples::length<ResultType>::value * sizeof(TermType1)>();
+					const BlockSizes blockSizes = computeBlockSizes<boost::tuples::length<ResultType>::value * sizeof(TermType1)>();
 
-					blockedMultiplication(blockSize, size1, size2, plainFunctor);
+					blockedMultiplication(blockSizes, computeRowEnds(terms1, multiplier.terms2, truncator), plainFunctor);
 				}
 
 
-				BaseSeriesMultiplier		    &multiplier;
-				Series1				            &retval;
-				std::vector<TermType1 const *>	terms1;
+				BaseSeriesMultiplier		                &multiplier;
+				Series1				                        &retval;
+				std::vector<TermType1 const *>	            terms1;
+				const settings::MultiplicationThresholds    thresholds;
 			};
 
 
@@ -277,9 +370,7 @@ namespace piranha
 			void performPlainThreadedMultiplication()
 			{
 				// Effective number of threads to use. If the two series are small, we want to use one single thread.
-				// NOTE: here the number 2500 is a kind of rule-of thumb. Basically multiplications of series < 50 elements
-				// will use just one thread.
-				if (double(terms1.size()) * double(terms2.size()) < 2500)
+				if (double(terms1.size()) * double(terms2.size()) < settings::getMultiplicationThresholds().threadedPlain)
                 {
 					stats::trace_stat("mult_st: plain-base", std::size_t(0), increment);
 
@@ -307,13 +398,14 @@ namespace piranha
 
 					// Last iteration.
 					split1[n - 1].insert(split1[n - 1].end(), terms1.begin() + (n - 1) * m, terms1.end());
-					boost::thread_group threadGroup;
 					std::vector<Series1> retvals(n, Series1());
+					std::vector<ThreadPool::Job> jobs;
 					for (std::size_t i = 0; i < n; ++i)
                     {
-						threadGroup.create_thread(PlainWorker(*DC, retvals[i], split1, i));
+						jobs.push_back(PlainWorker(*DC, retvals[i], split1, i));
 					}
-					threadGroup.join_all();
+					ThreadPool::run(jobs);
+					ThreadPool::traceStats();
 
 					// Take the retvals and insert them into final retval.
 					for (std::size_t i = 0; i < n; ++i)
@@ -28,6 +28,7 @@
 #include "../mp.h"
 #include "../settings.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <string>
 #include <vector>
@@ -43,6 +44,10 @@ namespace piranha
 	 * Overrides BaseSeries::realPower, BaseSeries::negativeIntegerPower, BaseSeries::rationalPower
 	 * and reimplements them using binomial expansion.
      * 
+	 * The series is written as A (1 + X/A), A being its leading term. (1 + X/A)^y is computed either through
+	 * the binomial expansion, i.e., by summing the powers of X/A, or through the J.C.P. Miller recurrence, which
+	 * builds the result one degree at a time from the terms of X/A of each degree. The latter needs a grading of
+	 * the series, which is provided by the degree truncator. The engine is chosen through settings::setPowerAlgorithm().
 	 */
     //
     // requires the SeriesMultiplication and truncator for the DerivedSeries
@@ -115,25 +120,134 @@ namespace piranha
 						+ ve.what());
 				}
 
+				if (settings::getPowerAlgorithm() != settings::PowerAlgorithm::BINOMIAL)
+				{
+					std::vector<Derived> grades;
+					if (gradeSeries(x_a, n, grades, argsTuple))
+					{
+						return millerRecurrence(a, grades, y, argsTuple);
+					}
+
+					if (settings::getPowerAlgorithm() == settings::PowerAlgorithm::MILLER)
+					{
+						PIRANHA_THROW(value_error, "Series is unsuitable for exponentiation through the J.C.P. Miller recurrence: "
+							"the degree truncator must be active and all the terms but the leading one must have a higher degree");
+					}
+				}
+
 				return binomialExpansion(a, x_a, y, n, argsTuple);
 			}
 
 
-			template <class Term, class Number, class ArgsTuple>
-			static Derived binomialExpansion(const Term &a, const Derived &x_a, const Number &y, const std::size_t n, const ArgsTuple &argsTuple)
+			// Split x_a into its terms of (partial) degree 1, 2, ..., as seen by the truncator. The terms of degree
+			// n * order or higher are dropped: the binomial expansion stops before the n-th power of x_a, whose order
+			// is not below the truncation limit. Returns false if the truncator does not grade x_a, or if some degrees
+			// are not positive integers.
+			template <class ArgsTuple>
+			static bool gradeSeries(const Derived &x_a, const int n, std::vector<Derived> &grades, const ArgsTuple &argsTuple)
 			{
 				typedef typename Derived::TermType TermType;
 
-                static_assert((std::is_same_v<Term, typename Derived::TermType>), "Term type mismatch in binomial expansion.");
+				mp_rational order;
+				try {
+					order = x_a.psOrder(argsTuple);
+
+				} catch (const value_error &)
+				{
+					return false;
+				}
+
+				if (order <= 0 || order.get_den() != 1)
+				{
+					return false;
+				}
+
+				grades.resize(static_cast<std::size_t>(n) * static_cast<std::size_t>(order.get_num().to_int()));
+				for (typename Derived::const_iterator it = x_a.begin(); it != x_a.end(); ++it)
+				{
+					Derived term;
+					term.insert(TermType(*it), argsTuple);
+					const mp_rational degree(term.psOrder(argsTuple));
+					if (degree.get_den() != 1)
+					{
+						return false;
+					}
+
+					PIRANHA_ASSERT(degree >= order);
+					const std::size_t k = static_cast<std::size_t>(degree.get_num().to_int());
+					if (k < grades.size())
+					{
+						grades[k].insert(TermType(*it), argsTuple);
+					}
+				}
+
+				return true;
+			}
+
+
+			// J.C.P. Miller recurrence. With x_k the terms of degree k of X/A, the terms of degree k of (1 + X/A)^y are
+			//
+			// h_0 = 1, h_k = 1/k sum_{j = 1}^{k} ((y + 1) j - k) x_j h_{k - j}.
+			//
+			// Every product involves two homogeneous parts, and the terms of degree grades.size() and higher are not computed,
+			// whereas the binomial expansion multiplies the whole of X/A by the whole of its previous power at every step.
+			template <class Term, class Number, class ArgsTuple>
+			static Derived millerRecurrence(const Term &a, const std::vector<Derived> &grades, const Number &y, const ArgsTuple &argsTuple)
+			{
+				std::vector<Derived> h(std::max<std::size_t>(grades.size(), 1));
+				h[0].baseAdd(1, argsTuple);
+				Derived retval(h[0]);
+
+				for (std::size_t k = 1; k < grades.size(); ++k)
+				{
+					for (std::size_t j = 1; j <= k; ++j)
+					{
+						const Number c = (y + 1) * boost::numeric_cast<int>(j) - boost::numeric_cast<int>(k);
+						if (grades[j].empty() || h[k - j].empty() || c == 0)
+						{
+							continue;
+						}
+
+						Derived tmp(grades[j]);
+						tmp.baseMultBy(c, argsTuple);
+						h[k].addmul_by_series(tmp, h[k - j], argsTuple);
+					}
+
+					h[k].baseDivideBy(boost::numeric_cast<int>(k), argsTuple);
+					retval.baseAdd(h[k], argsTuple);
+				}
+
+				retval.baseMultBy(leadingPower(a, y, argsTuple), argsTuple);
+
+				return retval;
+			}
+
+
+			// A^y, as a series.
+			template <class Term, class Number, class ArgsTuple>
+			static Derived leadingPower(const Term &a, const Number &y, const ArgsTuple &argsTuple)
+			{
+				typedef typename Derived::TermType TermType;
 
-				// Start the binomial expansion.
-				TermType tmpTerm;
 				// Calculate a**y. See if we can raise to real power the coefficient and the key.
 				// Exceptions will be thrown in case of problems.
+				TermType tmpTerm;
 				tmpTerm.cf  = a.cf.pow(y, argsTuple);
 				tmpTerm.key = a.key.pow(y, argsTuple);
-				Derived ay;
-				ay.insert(tmpTerm, argsTuple);
+				Derived retval;
+				retval.insert(tmpTerm, argsTuple);
+
+				return retval;
+			}
+
+
+			template <class Term, class Number, class ArgsTuple>
+			static Derived binomialExpansion(const Term &a, const Derived &x_a, const Number &y, const std::size_t n, const ArgsTuple &argsTuple)
+			{
+                static_assert((std::is_same_v<Term, typename Derived::TermType>), "Term type mismatch in binomial expansion.");
+
+				// Start the binomial expansion.
+				const Derived ay(leadingPower(a, y, argsTuple));
 				// Let's proceed now to the bulk of the binomial expansion. Luckily we can compute the needed generalised
 				// binomial coefficient incrementally at every step. We start with 1.
 				Derived retval;
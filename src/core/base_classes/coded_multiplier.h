@@ -23,6 +23,7 @@
 
 
 
+#include "../arena.h"
 #include "../config.h"
 #include "../exceptions.h"
 #include "../integer_typedefs.h"
@@ -31,19 +32,22 @@
 #include "../stats.h"
 #include "../type_traits.h"
 #include "../lambdas.h"
+#include "../work_stealing_executor.h"
 #include "coded_multiplier_mp.h"
 #include "null_truncator.h"
 
 #include <boost/functional/hash.hpp>
-#include <boost/iterator/permutation_iterator.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/numeric/interval.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/tuple/tuple_comparison.hpp> // We assert equality between vh tuples below.
+#include <boost/unordered_map.hpp>
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <exception>
 #include <iterator>
 #include <string>
 #include <utility>
@@ -63,290 +67,295 @@ namespace piranha
 {
 
 typedef std::pair<std::size_t, std::size_t> BlockType;
-typedef std::vector<BlockType>              BlockSequence;
-typedef boost::numeric::interval< MaxFastInt, boost::numeric::interval_lib::policies< boost::numeric::interval_lib::rounded_math<MaxFastInt>,
-	                                          boost::numeric::interval_lib::checking_base<MaxFastInt> > > 
-                                            BlockInterval;
 
 
-template <class Series1, class Series2, class ArgsTuple, class GenericTruncator, class Derived>
-struct BaseCodedFunctor
+/// Sorted view over the codes of a series.
+/**
+ * Used by the multi-threaded coded multipliers. The output code space is split into disjoint ranges and each
+ * range is handled by a single thread: for every term of the first series, the terms of the second series whose
+ * codes produce a result inside the range are located through a binary search in the sorted codes. Since ranges are
+ * disjoint, no synchronisation is needed when writing into the output structures.
+ *
+ * The codes vector is not modified, so that the relation between codes, coefficients and term pointers
+ * (on which the truncators rely) is preserved.
+ *
+ * Code is MaxFastInt or, for the wide coding tier, MaxWideInt.
+ */
+template <class Code>
+class BasicCodeRangeIndex
 {
-	typedef typename FinalCf<Series1>::Type CfType1;
-	typedef typename FinalCf<Series2>::Type CfType2;
-	typedef typename Series1::TermType TermType1;
-	typedef typename Series2::TermType TermType2;
-
+	public:
 
-    // 
-    // Functorial class providing the binary predicate (comaprison) operation for a std::sort
-    // It is indirect by sorting the indices not the vector itself
-	template <class Functor>
-	class IndirectSorter
-	{
-        public:
+		explicit BasicCodeRangeIndex(std::vector<Code> const &codes)
+        : m_positions(codes.size()), m_codes(codes.size())
+		{
+			for (std::size_t i = 0; i < m_positions.size(); ++i)
+			{
+				m_positions[i] = i;
+			}
+			std::sort(m_positions.begin(), m_positions.end(), IndexSorter(codes));
+			for (std::size_t i = 0; i < m_positions.size(); ++i)
+			{
+				m_codes[i] = codes[m_positions[i]];
+			}
+		}
 
-		IndirectSorter(Functor const &functor, std::vector<MaxFastInt> const &vec) : functor(functor), vec(vec) {}
 
-		bool operator()(std::size_t const n1, std::size_t const n2) const
+		/// Range of sorted positions [first, second[ such that code + codes[position] is in [lower, upper[.
+		BlockType find(Code const code, Code const lower, Code const upper) const
 		{
-			// TODO: numeric casts here, or maybe one large check at the beginning of the coded multiplier?
-			return functor.get_mem_pos(vec[n1]) < functor.get_mem_pos(vec[n2]);
+			PIRANHA_ASSERT(lower <= upper);
+
+			typename std::vector<Code>::const_iterator const first = std::lower_bound(m_codes.begin(), m_codes.end(), lower - code);
+
+			return BlockType(first - m_codes.begin(), std::lower_bound(first, m_codes.end(), upper - code) - m_codes.begin());
 		}
 
-        private:
-		Functor const			        &functor;
-		std::vector<MaxFastInt> const	&vec;
-	};
 
+		/// Index in the original codes vector of the n-th smallest code.
+		std::size_t position(std::size_t const n) const
+		{
+			PIRANHA_ASSERT(n < m_positions.size());
+			return m_positions[n];
+		}
 
-	BaseCodedFunctor(std::vector<CfType1>           &tc1, std::vector<CfType2>           &tc2,
-		             std::vector<MaxFastInt>      &ck1, std::vector<MaxFastInt>      &ck2,
-		             std::vector<TermType1 const *> &t1,  std::vector<TermType2 const *> &t2,
-		             GenericTruncator const &truncator,    ArgsTuple const &argsTuple)
-    : m_tc1(tc1), m_tc2(tc2), m_ck1(ck1), m_ck2(ck2), m_t1(t1), m_t2(t2), m_trunc(truncator), m_argsTuple(argsTuple)
-	{}
 
+		/// The n-th smallest code.
+		Code const &code(std::size_t const n) const
+		{
+			PIRANHA_ASSERT(n < m_codes.size());
+			return m_codes[n];
+		}
 
-	void baseBlocksSetup(std::size_t & currentIndex1Start, std::size_t const blockSize, BlockSequence &indexVector1, BlockSequence &indexVector2)
-	{
-//#ifdef _DEBUG
-//		std::cout << "BaseCodedFunctor::baseBlocksSetup" <<std::endl
-//			      << "currentIndex1Start: "              << currentIndex1Start  << std::endl
-//				  << "blockSize: "                       << blockSize           << std::endl
-//				  << "indexVector1 size: "               << indexVector1.size() << std::endl
-//				  << "indexVector2 size: "               << indexVector2.size() << std::endl;
-//#endif
-		PIRANHA_ASSERT(currentIndex1Start < m_tc1.size() && indexVector1.size() == indexVector2.size());
 
-		std::size_t upperBound1 = std::min<std::size_t>(m_tc1.size(), currentIndex1Start + indexVector1.size() * blockSize);
-		std::size_t	upperBound2 = std::min<std::size_t>(m_tc2.size(), indexVector2.size() * blockSize);
+		std::size_t size() const
+		{
+			return m_codes.size();
+		}
 
-		do {
-			// Now we must check the blocks for the following conditions:
-			// 1 - we must not be past the end of the series.
-			// 2 - the macroblocks must not result in overlapping areas in the output structure.
-			// 3 - the upper bound of each block must be different from the lower bound of next block.
-			// ---
-			// Determine the sequences, given upper and lower bounds.
-			determineSequence(indexVector1, currentIndex1Start, upperBound1);
-			determineSequence(indexVector2,                  0, upperBound2);
 
-			// Prepare lower-upper bounds for the next iteration, if any. But we never want to have less than 1 term in the whole sequence.
-			PIRANHA_ASSERT(upperBound1 > currentIndex1Start);
+		Code const &min() const
+		{
+			PIRANHA_ASSERT(m_codes.size());
+			return m_codes.front();
+		}
 
-			if (indexVector1.back().second - currentIndex1Start >= 2) 
-			{
-				upperBound1 = currentIndex1Start + (indexVector1.back().second - currentIndex1Start) / 2;
-			}
 
-			if (indexVector2.back().second >= 2) 
-			{
-				upperBound2 = indexVector2.back().second / 2;
-			}
+		Code const &max() const
+		{
+			PIRANHA_ASSERT(m_codes.size());
+			return m_codes.back();
+		}
 
-		} while (sequencesOverlap(indexVector1, indexVector2));
+	private:
 
-		// Blocks boundaries check.
-		adjustBlockBoundaries(indexVector1, m_ck1);
-		adjustBlockBoundaries(indexVector2, m_ck2);
+		class IndexSorter
+		{
+			public:
 
-		// Finally, update the currentIndex1Start.
-		currentIndex1Start = indexVector1.back().second;
+				IndexSorter(std::vector<Code> const &codes) : codes(codes) {}
 
-// std::cout << "init\n";
-// for (std::size_t i = 0; i < indexVector1.size(); ++i) {
-// 	std::cout << indexVector1[i].first << ',' << indexVector1[i].second << '\n';
-// }
-// for (std::size_t i = 0; i < indexVector2.size(); ++i) {
-// 	std::cout << indexVector2[i].first << ',' << indexVector2[i].second << '\n';
-// }
-// std::cout << "blah\n";
-	}
+				bool operator()(std::size_t const n1, std::size_t const n2) const
+				{
+					return codes[n1] < codes[n2];
+				}
 
+			private:
+				std::vector<Code> const &codes;
+		};
 
-	// Write into s a sequence of blocks ranging from index lower_bound to index upper_bound.
-	static void determineSequence(BlockSequence &s, std::size_t const lowerBound, std::size_t const upperBound)
-	{
-		PIRANHA_ASSERT(upperBound > lowerBound && s.size() > 0);
-		const std::size_t numBlocks = boost::numeric_cast<std::size_t>(s.size());
-        const std::size_t numTerms  = upperBound - lowerBound;
-		const std::size_t blockSize = (numBlocks > numTerms) ? 1 : numTerms / numBlocks;
-		for (std::size_t i = 0; i < numBlocks - 1; ++i) 
-		{
-			s[i].first  = std::min<std::size_t>(upperBound, lowerBound +  i      * blockSize);
-			s[i].second = std::min<std::size_t>(upperBound, lowerBound + (i + 1) * blockSize);
-		}
+		std::vector<std::size_t> m_positions;
+		std::vector<Code>        m_codes;
+};
 
-		// Handle the last block separately, as it might be non homogeneous.
-		s[numBlocks - 1].first = std::min<std::size_t>(upperBound, lowerBound + (numBlocks - 1) * blockSize);
-		s[numBlocks - 1].second = upperBound;
-	}
 
+typedef BasicCodeRangeIndex<MaxFastInt> CodeRangeIndex;
 
-	void adjustBlockBoundaries(BlockSequence &s, std::vector<MaxFastInt> const &ck) const
-	{
-//#ifdef _DEBUG
-//		std::cout << "BaseCodedFunctor::adjust_block_boundaries: ck size = " << ck.size() << std::endl;
-//#endif
-		PIRANHA_ASSERT(s.size() > 0);
 
-		for (BlockSequence::size_type i = 0; i < s.size() - 1; ++i) 
-		{
-			// Shrink non-empty blocks whose upper value's memory position is shared with the next block.
-//#ifdef _DEBUG
-//			std::cout << "BaseCodedFunctor::adjust_block_boundaries: blockSequence index = " << i << std::endl << std::flush;
-//			std::cout << "s[i] = " << s[i].first << "/" << s[i].second << std::endl << std::flush;
-//			std::cout << " upper/lower = " << s[i].second - 1 <<"/" << s[i + 1].first << std::endl << std::flush;  
-//#endif
-			while (s[i].first != s[i].second && (s[i+1].first < ck.size()) && derived_const_cast->get_mem_pos(ck[s[i].second - 1]) ==
-				derived_const_cast->get_mem_pos(ck[s[i + 1].first]))
-			{
-				--s[i].second;
-				--s[i + 1].first;
-//#ifdef _DEBUG
-//			std::cout << "s[i] = " << s[i].first << "/" << s[i].second << std::endl << std::flush;
-//			std::cout << " upper/lower = " << s[i].second - 1 <<"/" << s[i + 1].first << std::endl << std::flush;  
-//#endif
-			}
-		}
-	}
+/// Split the output code space of a coded multiplication into ranges of similar workload.
+/**
+ * The boundaries are estimated from the quantiles of a regular sample of the products' codes. The returned vector
+ * contains the boundaries of the ranges, which are [splits[i], splits[i + 1][. The first boundary is the smallest
+ * possible code, the last one is one past the largest possible code. Less than n ranges are returned if the
+ * sampled codes are not diverse enough.
+ *
+ * More than one index for the second series can be supplied when each pair of terms produces more than one
+ * code (e.g., the plus and minus codes of Poisson series multiplication).
+ */
+template <class Code>
+inline std::vector<Code> computeCodeSplits(std::vector<Code> const &ck1, std::vector<BasicCodeRangeIndex<Code> const *> const &indices2,
+                                           std::size_t const n)
+{
+	PIRANHA_ASSERT(ck1.size() && indices2.size() && n > 0);
 
+	// Number of samples per range.
+	static const std::size_t samplesPerRange = 64;
 
-	bool block2_advance(const BlockSequence &indexVector1, BlockSequence &indexVector2, const std::size_t &BlockSize, const BlockSequence &orig2, std::size_t &wrapCount) const
+	const Code min1 = *std::min_element(ck1.begin(), ck1.end());
+	const Code max1 = *std::max_element(ck1.begin(), ck1.end());
+	Code min2 = indices2[0]->min();
+	Code max2 = indices2[0]->max();
+	for (std::size_t k = 1; k < indices2.size(); ++k)
 	{
-		PIRANHA_DEBUG(std::cout << "coded_multiplier::block2_advance()" << std::endl << std::flush);
-		PIRANHA_ASSERT(indexVector1.size() == indexVector2.size() && indexVector1.size() > 0);
+		min2 = std::min(min2, indices2[k]->min());
+		max2 = std::max(max2, indices2[k]->max());
+	}
 
-		if (wrapCount)
+	std::vector<Code> retval;
+	retval.push_back(min1 + min2);
+	if (n > 1)
+	{
+		// Sample a regular grid of rows and columns.
+		std::vector<Code> samples;
+		const std::size_t rows = std::min<std::size_t>(ck1.size(), samplesPerRange * n);
+		for (std::size_t k = 0; k < indices2.size(); ++k)
 		{
-			PIRANHA_ASSERT(wrapCount < indexVector2.size());
-			if (wrapCount == indexVector2.size() - 1)
+			BasicCodeRangeIndex<Code> const &index2 = *indices2[k];
+			const std::size_t columns = std::min<std::size_t>(index2.size(), samplesPerRange);
+			for (std::size_t i = 0; i < rows; ++i)
 			{
-				// This means we are at the end.
-				return false;
-			}
-			// Shift down the blocks.
-			std::copy(indexVector2.begin() + 1, indexVector2.end(), indexVector2.begin());
-			// Get the new block from the originals.
-			indexVector2.back() = orig2[wrapCount];
-			// Increase the wrap count.
-			++wrapCount;
-		} else
-		{
-			// Shift down the blocks.
-			std::copy(indexVector2.begin() + 1, indexVector2.end(), indexVector2.begin());
-			// Set the new starting point for the last block.
-			indexVector2.back().first = indexVector2.back().second;
-			// Add the block size or stop at the end of the series, if necessary.
-			indexVector2.back().second = std::min<std::size_t>(m_tc2.size(), indexVector2.back().first + BlockSize);
-			// Now check if we are at the end of the first phase.
-			if (indexVector2.front() == BlockType(m_tc2.size(), m_tc2.size()))
-			{
-				if (indexVector2.size() > 1)
-				{
-					// If multi-threaded, insert at the end the first original block.
-					indexVector2.back() = orig2.front();
-					// Start the wrap count.
-					wrapCount = 1;
-				} else
+				const Code code1 = ck1[(i * ck1.size()) / rows];
+				for (std::size_t j = 0; j < columns; ++j)
 				{
-					// In single-threaded, this means we have finished.
-					return false;
+					samples.push_back(code1 + index2.code((j * index2.size()) / columns));
 				}
-			} else if (indexVector2.size() > 1)
+			}
+		}
+		std::sort(samples.begin(), samples.end());
+		for (std::size_t i = 1; i < n; ++i)
+		{
+			const Code split = samples[(i * samples.size()) / n];
+			if (split > retval.back())
 			{
-				// If we are not at the end of the first phase and we are multithreaded, we need to make sure the newly-added
-				// block does not overlap.
-				// NOTE: maybe this function can be replaced by direct check that the last block of first series
-				// by the newly added block in second series do not overlap with the remaining macroblock 1 by remaining
-				// macro block 2.
-				while (sequencesOverlap(indexVector1, indexVector2))
-				{
-					PIRANHA_ASSERT(indexVector2.back().second >= indexVector2.back().first);
-					indexVector2.back().second = indexVector2.back().first + (indexVector2.back().second - indexVector2.back().first) / 2;
-				}
+				retval.push_back(split);
 			}
 		}
-
-		// Make sure we have no overlaps.
-		PIRANHA_ASSERT(!sequencesOverlap(indexVector1, indexVector2));
-// std::cout << "after advance\n";
-// for (std::size_t i = 0; i < indexVector1.size(); ++i) {
-// 	std::cout << indexVector1[i].first << ',' << indexVector1[i].second << '\n';
-// }
-// for (std::size_t i = 0; i < indexVector2.size(); ++i) {
-// 	std::cout << indexVector2[i].first << ',' << indexVector2[i].second << '\n';
-// }
-// std::cout << "blappo\n";
-
-		return true;
 	}
+	retval.push_back(max1 + max2 + 1);
 
-
-	static bool intervalSorter(BlockInterval const &i1,  BlockInterval const &i2)
-	{
-		return i1.lower() < i2.lower();
-	}
+	return retval;
+}
 
 
-	bool sequencesOverlap(BlockSequence const &s1,  BlockSequence const &s2) const
-	{
-		PIRANHA_ASSERT(s1.size() == s2.size() && s1.size() > 0);
+template <class Code>
+inline std::vector<Code> computeCodeSplits(std::vector<Code> const &ck1, BasicCodeRangeIndex<Code> const &index2, std::size_t const n)
+{
+	return computeCodeSplits(ck1, std::vector<BasicCodeRangeIndex<Code> const *>(1, &index2), n);
+}
 
-		typedef std::vector<BlockInterval>::size_type size_type;
 
-		std::vector<BlockInterval> vi;
-		for (size_type i = 0; i < s1.size(); ++i) 
+/// Multiply the pairs of terms whose codes add up to a value in [lower, upper[.
+/**
+ * Only the rows of the first series that can produce codes in the range are visited, in increasing code order.
+ * The functor is called with the indices of the terms in the original (unsorted) codes vectors. Row i is visited
+ * up to column rowEnds[i] excluded (see BaseSeriesMultiplier::computeRowEnds()), so that the pairs cut by the
+ * truncator are not multiplied. Since the columns are not visited in the truncator's order, the return value
+ * of the functor is ignored: a skipped pair does not end the row.
+ */
+template <class Functor, class Code>
+inline void codeRangeMultiplication(Functor &functor, BasicCodeRangeIndex<Code> const &index1, BasicCodeRangeIndex<Code> const &index2,
+                                    std::vector<std::size_t> const &rowEnds, Code const lower, Code const upper)
+{
+	const BlockType rows = index1.find(0, lower - index2.max(), upper - index2.min());
+	for (std::size_t n = rows.first; n < rows.second; ++n)
+	{
+		const std::size_t i      = index1.position(n);
+		const std::size_t rowEnd = rowEnds[i];
+		if (rowEnd == 0)
 		{
-			std::pair<BlockInterval, BlockInterval> tmp(derived_const_cast->blocksToIntervals(s1[i], s2[i]));
-			if (!boost::numeric::empty(tmp.first)) 
-			{
-				vi.push_back(tmp.first);
-			}
-
-			if (!boost::numeric::empty(tmp.second)) 
+			continue;
+		}
+		const BlockType range = index2.find(index1.code(n), lower, upper);
+		for (std::size_t k = range.first; k < range.second; ++k)
+		{
+			const std::size_t j = index2.position(k);
+			if (j < rowEnd)
 			{
-				vi.push_back(tmp.second);
+				functor(i, j);
 			}
 		}
+	}
+}
 
-		if (!vi.size()) 
-		{
-			return false;
-		}
-		// Sort according to lower bound of the interval.
-		std::sort(vi.begin(), vi.end(), intervalSorter);
 
-		PIRANHA_ASSERT(vi.size() > 0);
+/// Task multiplying the pairs of terms whose codes add up to a value in [lower, upper[.
+/**
+ * To be run through piranha::WorkStealingExecutor. Tasks built on disjoint ranges write into disjoint
+ * regions of the output structures.
+ */
+template <class Functor, class Code = MaxFastInt>
+struct CodeRangeTask
+{
+	CodeRangeTask(Functor const &functor, BasicCodeRangeIndex<Code> const &index1, BasicCodeRangeIndex<Code> const &index2,
+	              std::vector<std::size_t> const &rowEnds, Code const lower, Code const upper)
+    : m_functor(functor), m_index1(index1), m_index2(index2), m_rowEnds(rowEnds), m_lower(lower), m_upper(upper)
+	{}
+
 
-		// Check that all intervals are disjoint.
-		for (size_type i = 0; i < vi.size() - 1; ++i) 
-		{
-			if (vi[i].upper() >= vi[i + 1].lower()) 
-			{
-				return true;
-			}
-		}
-		return false;
+	void operator()()
+	{
+		codeRangeMultiplication(m_functor, m_index1, m_index2, m_rowEnds, m_lower, m_upper);
 	}
 
 
-	// TODO: rewrite with iterators for genericity? Or maybe provide alternative version.
-	template <class T>
-	static void apply_permutation(const std::vector<std::size_t> &perm, std::vector<T> &v)
+	Functor                         m_functor;
+	BasicCodeRangeIndex<Code> const &m_index1;
+	BasicCodeRangeIndex<Code> const &m_index2;
+	std::vector<std::size_t> const  &m_rowEnds;
+	const Code                      m_lower;
+	const Code                      m_upper;
+};
+
+
+/// Task decoding the results of vector coded multiplication whose codes lie in [lower, upper[.
+/**
+ * Decoder is called as decoder(lower, upper, out) and must push_back() into out the canonical terms decoded from the
+ * non-ignorable coefficients of the range. Its static member uniqueTerms tells whether the decoded terms are unique
+ * by construction (i.e., canonicalisation never maps two codes onto the same term). Tasks built on disjoint ranges
+ * touch disjoint regions of the vector of coefficients, hence they can be run concurrently.
+ */
+template <class Decoder, class Term>
+struct CodeDecodeTask
+{
+	CodeDecodeTask(Decoder const &decoder, MaxFastInt const lower, MaxFastInt const upper)
+    : m_decoder(decoder), m_lower(lower), m_upper(upper)
+	{}
+
+
+	void operator()()
 	{
-		typedef boost::permutation_iterator<typename std::vector<T>::iterator, std::vector<std::size_t>::const_iterator> perm_iterator;
-		std::vector<T> other(v.size());
-		std::copy(perm_iterator(v.begin(), perm.begin()), perm_iterator(v.end(), perm.end()), other.begin());
-		other.swap(v);
+		m_decoder(m_lower, m_upper, m_terms);
 	}
 
 
+	Decoder const                  &m_decoder;
+	const MaxFastInt                m_lower;
+	const MaxFastInt                m_upper;
+	std::vector<Term>               m_terms;
+};
+
+
+template <class Series1, class Series2, class ArgsTuple, class GenericTruncator, class Derived, class Code = MaxFastInt>
+struct BaseCodedFunctor
+{
+	typedef typename FinalCf<Series1>::Type CfType1;
+	typedef typename FinalCf<Series2>::Type CfType2;
+	typedef typename Series1::TermType TermType1;
+	typedef typename Series2::TermType TermType2;
+
+
+	BaseCodedFunctor(std::vector<CfType1>           &tc1, std::vector<CfType2>           &tc2,
+		             std::vector<Code>              &ck1, std::vector<Code>              &ck2,
+		             std::vector<TermType1 const *> &t1,  std::vector<TermType2 const *> &t2,
+		             GenericTruncator const &truncator,    ArgsTuple const &argsTuple)
+    : m_tc1(tc1), m_tc2(tc2), m_ck1(ck1), m_ck2(ck2), m_t1(t1), m_t2(t2), m_trunc(truncator), m_argsTuple(argsTuple)
+	{}
+
+
 	std::vector<CfType1>		    &m_tc1;
 	std::vector<CfType2>		    &m_tc2;
-	std::vector<MaxFastInt>	    &m_ck1;
-	std::vector<MaxFastInt>	    &m_ck2;
+	std::vector<Code>		        &m_ck1;
+	std::vector<Code>		        &m_ck2;
 	std::vector<TermType1 const *>  &m_t1;
 	std::vector<TermType2 const *>  &m_t2;
 	const GenericTruncator		    &m_trunc;
@@ -354,12 +363,56 @@ struct BaseCodedFunctor
 };
 
 
+/// Functor for the coded squaring of a series.
+/**
+ * When squaring, the two input series are the same, hence the pairs (i, j) and (j, i) yield the same product (for Poisson series,
+ * once the decoded terms are canonicalised): only the pairs
+ * with j >= i are multiplied, the diagonal ones through the first functor, the others through the second one, built on
+ * the doubled coefficients of the second series. The pairs with j < i are ignored, so that the functor can also be fed with all
+ * the pairs of a code range. When not squaring, all the pairs are forwarded to the first functor.
+ *
+ * The truncator's skip() must be symmetric, which is the case for the truncators of the same series.
+ */
+template <class Functor>
+struct CodedSquaringFunctor
+{
+	CodedSquaringFunctor(Functor const &diagonal, Functor const &offDiagonal, bool const squaring)
+    : m_diagonal(diagonal), m_offDiagonal(offDiagonal), m_squaring(squaring)
+	{}
+
+
+	bool operator()(std::size_t const i, std::size_t const j)
+	{
+		if (!m_squaring)
+		{
+			return m_diagonal(i, j);
+		}
+		if (j < i)
+		{
+			return true;
+		}
+
+		return (i == j) ? m_diagonal(i, j) : m_offDiagonal(i, j);
+	}
+
+
+	Functor		m_diagonal;
+	Functor		m_offDiagonal;
+	const bool	m_squaring;
+};
+
+
 	/// Toolbox for coded series multiplication.
 	/**
 	 * Intended to be inherited together with piranha::BaseSeriesMultiplier. It adds common methods for
 	 * series multiplication through Kronecker codification. Requirements:
 	 * - input series must have at least one term;
 	 * - input series must have at least one argument.
+	 *
+	 * Codes are MaxFastInt integers. When their range does not fit into MaxFastInt, the terms are coded with MaxWideInt
+	 * integers instead (wide tier), which are supported by hash coded multiplication only. When not even MaxWideInt
+	 * is enough, the variables are split into groups, each one coded separately into a MaxFastInt (split coding):
+	 * the first group is the inner one, the others form the outer key.
 	 */
 	template <class Derived, class Series1, class Series2, class OpTuple>
 	class CodedMultiplier
@@ -381,6 +434,11 @@ struct BaseCodedFunctor
 			typedef typename cm_tuple<Series1>::type_coding_tuple fast_coding_tuple_type;
 			// Decoding tuple.
 			typedef typename cm_tuple<Series1>::type_decoding_tuple decoding_tuple_type;
+			// Coding and decoding tuples of the wide coding tier.
+			typedef typename cm_tuple<Series1>::type_wide_coding_tuple wide_coding_tuple_type;
+			typedef typename cm_tuple<Series1>::type_wide_decoding_tuple wide_decoding_tuple_type;
+			// Decoding tuple of split coding.
+			typedef typename cm_tuple<Series1>::type_split_decoding_tuple split_decoding_tuple_type;
 			// These static checks makes sure that the two series have compatible types in the echelon
 			// hierarchy, apart from the numerical coefficients.
             static_assert((std::is_same_v<minmax_type, typename cm_tuple<Series2>::type_minmax>), "");
@@ -403,7 +461,9 @@ struct BaseCodedFunctor
 			{
 				MULTIPLICATION_PLAIN   = 0,
 				MULTIPLICATION_VECTOR = 1,
-				MULTIPLICATION_HASH   = 2
+				MULTIPLICATION_HASH   = 2,
+				MULTIPLICATION_SPLIT  = 3,
+				MULTIPLICATION_HEAP   = 4
 			};
 
 
@@ -420,6 +480,12 @@ struct BaseCodedFunctor
 						break;
 					case MULTIPLICATION_HASH:
 						name = "multiplication_hash";
+						break;
+					case MULTIPLICATION_SPLIT:
+						name = "multiplication_split";
+						break;
+					case MULTIPLICATION_HEAP:
+						name = "multiplication_heap";
 				}
 				stats::trace_stat(name, std::size_t(0), increment);
 			}
@@ -432,7 +498,9 @@ struct BaseCodedFunctor
 			 * piranha::BaseSeriesMultiplier.
 			 */
 			CodedMultiplier()
-            : m_gr_is_viable(false), m_mp_h(mp_integer(0)), m_fast_h(0), m_density1(0.), m_density2(0.)
+            : m_gr_is_viable(false), m_mp_h(mp_integer(0)), m_fast_h(0), m_wide(false), m_wide_lower(0), m_wide_upper(0),
+              m_split(false), m_split_width(0), m_density1(0.), m_density2(0.), m_width(0.),
+              m_accumulate(!derived_const_cast->retval.empty())
 			{
 				// NOTE: beware the order of inheritance here, make sure to init BaseSeriesMultiplier before,
 				//       otherwise m_argsTuple will be uninitialised here.
@@ -441,6 +509,8 @@ struct BaseCodedFunctor
 				cm_init_vector_tuple<Series1>(m_fast_gr, derived_const_cast->argsTuple);
 				cm_init_vector_tuple<Series1>(m_mp_ct,   derived_const_cast->argsTuple);
 				cm_init_vector_tuple<Series1>(m_fast_ct, derived_const_cast->argsTuple);
+				cm_init_vector_tuple<Series1>(m_wide_ct, derived_const_cast->argsTuple);
+				cm_init_vector_tuple<Series1>(m_split_dt, derived_const_cast->argsTuple);
 			}
 
 
@@ -463,8 +533,8 @@ struct BaseCodedFunctor
 				}
 				
 				//std::cout << "coded_multiplier::performMultiplication  : 0" << std::endl << std::flush;
-                // NOTE: hard coded value of 1000.
-				if ((algo == settings::MultiplicationAlgorithm::AUTOMATIC && double(derived_cast->terms1.size()) * double(derived_cast->terms2.size()) < 1000)
+				if ((algo == settings::MultiplicationAlgorithm::AUTOMATIC
+						&& double(derived_cast->terms1.size()) * double(derived_cast->terms2.size()) < settings::getMultiplicationThresholds().plainCoded)
 					|| algo == settings::MultiplicationAlgorithm::PLAIN)
 				{
 					derived_cast->performPlainMultiplication();
@@ -478,7 +548,8 @@ struct BaseCodedFunctor
 				determineViability();
 				if (!m_gr_is_viable)
 				{
-					if (algo == settings::MultiplicationAlgorithm::VECTOR_CODED || algo == settings::MultiplicationAlgorithm::HASH_CODED)
+					if (algo == settings::MultiplicationAlgorithm::VECTOR_CODED || algo == settings::MultiplicationAlgorithm::HASH_CODED
+						|| algo == settings::MultiplicationAlgorithm::HEAP_CODED || algo == settings::MultiplicationAlgorithm::FFT)
                     {
 						PIRANHA_THROW(value_error, "coded multiplication requested, but coded representation is not feasible");
 					}
@@ -524,10 +595,41 @@ struct BaseCodedFunctor
 				std::insert_iterator<std::vector<CfType2> > itCache2(cf2Cache, cf2Cache.begin());
 				std::transform(derived_cast->terms1.begin(), derived_cast->terms1.end(), itCache1, final_cf_getter<Series1>());
 				std::transform(derived_cast->terms2.begin(), derived_cast->terms2.end(), itCache2, final_cf_getter<Series2>());
+
+				if (m_split)
+				{
+					if (algo == settings::MultiplicationAlgorithm::VECTOR_CODED || algo == settings::MultiplicationAlgorithm::FFT) 
+					{
+						PIRANHA_THROW(value_error, "vector coded multiplication requested, but vector coded representation is infeasible");
+					}
+					if (algo == settings::MultiplicationAlgorithm::HEAP_CODED)
+					{
+						PIRANHA_THROW(value_error, "heap coded multiplication requested, but the codes do not fit into a single integer");
+					}
+					shiftCodes();
+					derived_cast->performSplitCodedMultiplication(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc);
+					trace_mult_type(MULTIPLICATION_SPLIT);
+					return;
+				}
 				
+				if (algo == settings::MultiplicationAlgorithm::HEAP_CODED)
+				{
+					shiftCodes();
+					const bool heap_res = m_wide
+						? derived_cast->template performHeapCodedMultiplication<MaxWideInt>(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc)
+						: derived_cast->template performHeapCodedMultiplication<MaxFastInt>(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc);
+					if (!heap_res)
+					{
+						PIRANHA_THROW(value_error, "heap coded multiplication requested, but it is not available for this series type");
+					}
+					trace_mult_type(MULTIPLICATION_HEAP);
+					return;
+				}
+
                 bool vec_res;
 				
-                if ((algo == settings::MultiplicationAlgorithm::AUTOMATIC && is_sparse()) || algo == settings::MultiplicationAlgorithm::HASH_CODED) 
+                // NOTE: codes of the wide tier span far too many values for a vector.
+                if (m_wide || (algo == settings::MultiplicationAlgorithm::AUTOMATIC && is_sparse()) || algo == settings::MultiplicationAlgorithm::HASH_CODED) 
 				{
 					vec_res = false;
 				} else 
@@ -539,14 +641,20 @@ struct BaseCodedFunctor
 
 				if (!vec_res) 
 				{
-					if (algo == settings::MultiplicationAlgorithm::VECTOR_CODED) 
+					if (algo == settings::MultiplicationAlgorithm::VECTOR_CODED || algo == settings::MultiplicationAlgorithm::FFT) 
 					{
 						PIRANHA_THROW(value_error, "vector coded multiplication requested, but vector coded representation is infeasible");
 					}
 
 					shiftCodes();
 
-					derived_cast->performHashCodedMultiplication(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc);
+					if (m_wide)
+					{
+						derived_cast->template performHashCodedMultiplication<MaxWideInt>(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc);
+					} else
+					{
+						derived_cast->template performHashCodedMultiplication<MaxFastInt>(cf1Cache, cf2Cache, derived_cast->terms1, derived_cast->terms2, trunc);
+					}
 					
                     trace_mult_type(MULTIPLICATION_HASH);
 				} else 
@@ -607,10 +715,15 @@ struct BaseCodedFunctor
 				// To test whether a representation is viable or not, we need to test for the following things:
 				// - m_mp_h must be in the MaxFastInt range;
 				// - m_mp_h's width must be within halft MaxFastInt's range (needed for 2*chi shifting).
+				// If that fails, the same test is repeated for MaxWideInt: the codes are then handled by the wide tier,
+				// which supports only hash coded multiplication. As a last resort, split coding is tried.
 				// Use lexical cast for max interoperability between numerical types.
 				// NOTE: here probably we can reduce greatly the number of memory allocations...
 //                auto f = [](const std::size_t x) -> std::size_t { return x + 1; }; // increment functor
 
+				m_wide  = false;
+				m_split = false;
+				const mp_integer maxWide(cm_max_wide());
 				if (boost::numeric::subset(m_mp_h,boost::numeric::interval<mp_integer>(
 					boost::lexical_cast<mp_integer>(std::numeric_limits<MaxFastInt>::min()),
 					boost::lexical_cast<mp_integer>(std::numeric_limits<MaxFastInt>::max()))) &&
@@ -621,6 +734,19 @@ struct BaseCodedFunctor
 					m_gr_is_viable = true;
 					// Log viability.
                     stats::trace_stat("mult_coded_feasible", std::size_t(0), increment);
+				} else if (boost::numeric::subset(m_mp_h, boost::numeric::interval<mp_integer>(-maxWide, maxWide)) &&
+					boost::numeric::width(m_mp_h) <= maxWide / 2)
+				{
+					m_gr_is_viable = true;
+					m_wide         = true;
+					stats::trace_stat("mult_coded_feasible", std::size_t(0), increment);
+					stats::trace_stat("mult_coded_wide", std::size_t(0), increment);
+				} else if (determineSplit())
+				{
+					m_gr_is_viable = true;
+					m_split        = true;
+					stats::trace_stat("mult_coded_feasible", std::size_t(0), increment);
+					stats::trace_stat("mult_coded_split", std::size_t(0), increment);
 				} else 
 				{
 					stats::trace_stat("mult_coded_unfeasible", std::size_t(0), increment);
@@ -635,43 +761,38 @@ struct BaseCodedFunctor
 
 				// Downcast multiprecision to fast representation.
 				cm_mp_tuple_downcast(m_mp_gr, m_fast_gr);
-				cm_mp_tuple_downcast(m_mp_ct, m_fast_ct);
-				m_fast_h.assign(boost::lexical_cast<MaxFastInt>(m_mp_h.lower()), boost::lexical_cast<MaxFastInt>(m_mp_h.upper()));
-				// Build decoding tuple.
-				cm_build_decoding_tuple(m_dt, m_fast_gr);
-				// Establish if subtraction is requested or not.
-				static const bool sub_requested = op_has_sub<OpTuple>::value;
-				// Resize codes vectors.
-				typedef std::vector<MaxFastInt>::size_type size_type;
-				const size_type csize1 = boost::numeric_cast<size_type>(derived_const_cast->terms1.size());
-				const size_type csize2 = boost::numeric_cast<size_type>(derived_const_cast->terms2.size());
-				m_ckeys1.resize(csize1);
-				m_ckeys2a.resize(csize2);
-				if (sub_requested) 
-				{
-					m_ckeys2b.resize(csize2);
-				}
-				// Now fill in the codes.
-				MaxFastInt code_a = 0, code_b = 0;
-				for (size_type i = 0; i < csize1; ++i) 
+				if (m_split)
 				{
-					cm_code<OpTuple>(m_fast_ct, *derived_const_cast->terms1[i], m_vh,code_a, code_b);
-					m_ckeys1[i] = code_a;
-				}
-
-				for (size_type i = 0; i < csize2; ++i) 
-				{
-					cm_code<OpTuple>(m_fast_ct, *derived_const_cast->terms2[i], m_vh,code_a, code_b);
-					m_ckeys2a[i] = code_a;
-					if (sub_requested) 
+					const std::size_t groups = m_split_ct.size();
+					m_split_ckeys1.resize(groups);
+					m_split_ckeys2a.resize(groups);
+					m_split_ckeys2b.resize(groups);
+					for (std::size_t g = 0; g < groups; ++g)
 					{
-						m_ckeys2b[i] = code_b;
+						code_terms_impl(m_split_ct[g], m_split_ckeys1[g], m_split_ckeys2a[g], m_split_ckeys2b[g]);
 					}
+					// Only the inner codes are relevant for the densities.
+					m_width = static_cast<double>(m_split_width);
+				} else if (m_wide)
+				{
+					cm_mp_tuple_downcast(m_mp_ct, m_wide_ct);
+					m_wide_lower = cm_mp_to_wide(m_mp_h.lower());
+					m_wide_upper = cm_mp_to_wide(m_mp_h.upper());
+					cm_build_decoding_tuple(m_wide_dt, m_fast_gr);
+					code_terms_impl(m_wide_ct, m_wide_ckeys1, m_wide_ckeys2a, m_wide_ckeys2b);
+					m_width = static_cast<double>(m_wide_upper - m_wide_lower) + 1;
+				} else
+				{
+					cm_mp_tuple_downcast(m_mp_ct, m_fast_ct);
+					m_fast_h.assign(boost::lexical_cast<MaxFastInt>(m_mp_h.lower()), boost::lexical_cast<MaxFastInt>(m_mp_h.upper()));
+					// Build decoding tuple.
+					cm_build_decoding_tuple(m_dt, m_fast_gr);
+					code_terms_impl(m_fast_ct, m_ckeys1, m_ckeys2a, m_ckeys2b);
+					m_width = static_cast<double>(boost::numeric::width(m_fast_h) + 1);
 				}
 				// Compute densities.
-				const MaxFastInt w = boost::numeric::width(m_fast_h) + 1;
-				m_density1 = static_cast<double>(csize1) / w;
-				m_density2 = static_cast<double>(csize2) / w;
+				m_density1 = static_cast<double>(derived_const_cast->terms1.size()) / m_width;
+				m_density2 = static_cast<double>(derived_const_cast->terms2.size()) / m_width;
 			}
 
 
@@ -679,22 +800,48 @@ struct BaseCodedFunctor
 			/**
 			 * Decode given code into return value term, using final_cf as the coefficient at the end of the echelon recursion.
 			 */
+			template <class FinalCf, class Code>
+			void decode(const FinalCf &final_cf, const Code &code, typename Series1::TermType &term) const
+			{
+				if constexpr (std::is_same_v<Code, MaxWideInt>)
+				{
+					PIRANHA_ASSERT(m_wide);
+					cm_decode(final_cf, m_wide_dt, m_fast_gr, term, m_vh, code, m_wide_lower, derived_const_cast->argsTuple);
+				} else
+				{
+					PIRANHA_ASSERT(!m_wide);
+					cm_decode(final_cf, m_dt, m_fast_gr, term, m_vh, code, m_fast_h.lower(), derived_const_cast->argsTuple);
+				}
+			}
+
+
+			/// Decode the inner code and the outer codes of split coding.
+			/**
+			 * The inner code is the sum of two shifted codes, as in hash coded multiplication; the outer codes are not shifted.
+			 */
 			template <class FinalCf>
-			void decode(const FinalCf &final_cf, const MaxFastInt &code, typename Series1::TermType &term) const
+			void decodeSplit(const FinalCf &final_cf, const MaxFastInt &inner, const std::vector<MaxFastInt> &outer,
+			                 typename Series1::TermType &term) const
 			{
-				cm_decode(final_cf, m_dt, m_fast_gr, term, m_vh, code, m_fast_h.lower(), derived_const_cast->argsTuple);
+				PIRANHA_ASSERT(m_split && outer.size() + 1 == m_split_min.size());
+				std::vector<MaxFastInt> codes(m_split_min.size());
+				codes[0] = inner + m_split_min[0];
+				for (std::size_t g = 1; g < codes.size(); ++g)
+				{
+					codes[g] = outer[g - 1] - m_split_min[g];
+				}
+				cm_split_decode(final_cf, m_split_dt, m_fast_gr, term, m_vh, codes, derived_const_cast->argsTuple);
 			}
 
 
 			/// Determine whether coded representation is sparse.
 			/**
 			 * Must be called only if representation is viable, otherwise runtime assertion will fail. Density is compared
-			 * against value hard-coded internally.
+			 * against the sparse density threshold of piranha::settings.
 			 */
 			bool is_sparse() const
 			{
-				// Magic value established empirically. Possibly subject to tuning in the future.
-				static const double limit = 1E-4;
+				const double limit = settings::getMultiplicationThresholds().sparseDensity;
 				// We don't want this to be called if we haven't established the suitability
 				// of the coded representation first.
 				PIRANHA_ASSERT(m_gr_is_viable);
@@ -711,36 +858,323 @@ struct BaseCodedFunctor
 			{
 				PIRANHA_ASSERT(m_gr_is_viable);
 
-				typedef std::vector<MaxFastInt>::size_type size_type;
-				
-                const size_type size1  = m_ckeys1.size();
-                const size_type size2a = m_ckeys2a.size();
-                const size_type size2b = m_ckeys2b.size();
-				const MaxFastInt chi = m_fast_h.lower();
+				if (m_split)
+				{
+					// Only the inner codes go into hash tables.
+					shiftCodesImpl(m_split_ckeys1[0], m_split_min[0]);
+					shiftCodesImpl(m_split_ckeys2a[0], m_split_min[0]);
+					shiftCodesImpl(m_split_ckeys2b[0], m_split_min[0]);
+				} else if (m_wide)
+				{
+					shiftCodesImpl(m_wide_ckeys1, m_wide_lower);
+					shiftCodesImpl(m_wide_ckeys2a, m_wide_lower);
+					shiftCodesImpl(m_wide_ckeys2b, m_wide_lower);
+				} else
+				{
+					shiftCodesImpl(m_ckeys1, m_fast_h.lower());
+					shiftCodesImpl(m_ckeys2a, m_fast_h.lower());
+					shiftCodesImpl(m_ckeys2b, m_fast_h.lower());
+				}
+			}
 
-				for (size_type i = 0; i < size1; ++i) 
+		protected:
+			/// Codes of the first series in the coding tier of Code.
+			template <class Code>
+			std::vector<Code> &codes1()
+			{
+				if constexpr (std::is_same_v<Code, MaxWideInt>)
 				{
-					m_ckeys1[i] -= chi;
-				
-                	PIRANHA_ASSERT(m_ckeys1[i] >= 0);
+					return m_wide_ckeys1;
+				} else
+				{
+					return m_ckeys1;
 				}
+			}
 
-				for (size_type i = 0; i < size2a; ++i) 
+
+			/// Codes of the second series in the coding tier of Code, plus.
+			template <class Code>
+			std::vector<Code> &codes2a()
+			{
+				if constexpr (std::is_same_v<Code, MaxWideInt>)
+				{
+					return m_wide_ckeys2a;
+				} else
 				{
-					m_ckeys2a[i] -= chi;
+					return m_ckeys2a;
+				}
+			}
 
-					PIRANHA_ASSERT(m_ckeys2a[i] >= 0);
+
+			/// Codes of the second series in the coding tier of Code, minus.
+			template <class Code>
+			std::vector<Code> &codes2b()
+			{
+				if constexpr (std::is_same_v<Code, MaxWideInt>)
+				{
+					return m_wide_ckeys2b;
+				} else
+				{
+					return m_ckeys2b;
 				}
+			}
 
-				for (size_type i = 0; i < size2b; ++i) 
+
+			/// Minimum code of the representation in the coding tier of Code.
+			template <class Code>
+			Code minCode() const
+			{
+				if constexpr (std::is_same_v<Code, MaxWideInt>)
 				{
-					m_ckeys2b[i] -= chi;
-				
-                	PIRANHA_ASSERT(m_ckeys2b[i] >= 0);
+					return m_wide_lower;
+				} else
+				{
+					return m_fast_h.lower();
+				}
+			}
+
+
+			/// Terms sharing the same outer codes in split coding.
+			struct SplitBucket
+			{
+				std::vector<MaxFastInt>	outer;
+				std::vector<std::size_t>	terms;
+			};
+
+
+			/// Group the terms of a series by their outer codes in split coding.
+			/**
+			 * ckeys contains the codes of each group of variables, as in m_split_ckeys1.
+			 */
+			static std::vector<SplitBucket> splitBuckets(const std::vector<std::vector<MaxFastInt> > &ckeys)
+			{
+				PIRANHA_ASSERT(ckeys.size() > 1);
+				boost::unordered_map<std::vector<MaxFastInt>, std::size_t> index;
+				std::vector<SplitBucket> retval;
+				SplitBucket bucket;
+				bucket.outer.resize(ckeys.size() - 1);
+				for (std::size_t i = 0; i < ckeys[0].size(); ++i)
+				{
+					for (std::size_t g = 1; g < ckeys.size(); ++g)
+					{
+						bucket.outer[g - 1] = ckeys[g][i];
+					}
+					const std::pair<typename boost::unordered_map<std::vector<MaxFastInt>, std::size_t>::iterator, bool>
+						res = index.insert(std::make_pair(bucket.outer, retval.size()));
+					if (res.second)
+					{
+						retval.push_back(bucket);
+					}
+					retval[res.first->second].terms.push_back(i);
+				}
+				return retval;
+			}
+
+
+			/// Outer codes of the product of two terms in split coding.
+			static void splitOuterSum(const std::vector<MaxFastInt> &outer1, const std::vector<MaxFastInt> &outer2, std::vector<MaxFastInt> &retval)
+			{
+				PIRANHA_ASSERT(outer1.size() == outer2.size());
+				retval.resize(outer1.size());
+				for (std::size_t g = 0; g < outer1.size(); ++g)
+				{
+					retval[g] = outer1[g] + outer2[g];
 				}
 			}
 
+
+			/// Expected number of terms in the hash table of hash coded multiplication.
+			std::size_t hashSizeHint() const
+			{
+				return static_cast<std::size_t>(std::max<double>(m_density1, m_density2) * m_width);
+			}
+
+
+			/// Chunk size of the arena of hash coded multiplication, for table entries of Size bytes.
+			/**
+			 * Room for a few times the expected number of terms, so that the small tables and their first resizes share
+			 * one chunk, capped to the default chunk size of piranha::Arena.
+			 */
+			template <std::size_t Size>
+			std::size_t hashArenaChunkSize() const
+			{
+				return std::min<std::size_t>(std::max<std::size_t>(4 * Size * hashSizeHint(), 4096), Arena::defaultChunkSize);
+			}
+
+
+			/// Whether the multiplication is the squaring of a series.
+			/**
+			 * True when the two input series are the same object and their terms are in the same order, which
+			 * is the case unless they were sorted differently (e.g., after the flattening of echelon level
+			 * greater than zero series, which does not preserve the term pointers).
+			 */
+			bool isSquaring() const
+			{
+				if constexpr (!std::is_same_v<Series1, Series2>)
+				{
+					return false;
+				} else
+				{
+					return &derived_const_cast->series1 == &derived_const_cast->series2
+						&& derived_const_cast->terms1 == derived_const_cast->terms2;
+				}
+			}
+
+
+			/// Doubled coefficients, for the off-diagonal pairs of coded squaring.
+			template <class Cf>
+			std::vector<Cf> doubledCoefficients(std::vector<Cf> const &tc) const
+			{
+				std::vector<Cf> retval(tc);
+				for (std::size_t i = 0; i < retval.size(); ++i)
+				{
+					retval[i].multBy(2, derived_const_cast->argsTuple);
+				}
+				return retval;
+			}
+
+
+			/// Heap coded multiplication, for the derived classes which do not implement it.
+			/**
+			 * Returns false, so that requesting heap coded multiplication results in an error.
+			 */
+			template <class Code, class Cf1, class Cf2, class Term1, class Term2, class GenericTruncator>
+			bool performHeapCodedMultiplication(std::vector<Cf1> &, std::vector<Cf2> &, std::vector<Term1 const *> &, std::vector<Term2 const *> &,
+			                                    GenericTruncator const &)
+			{
+				return false;
+			}
+
 		protected:
+			/// Decode the results of vector coded multiplication and insert them into the return value.
+			/**
+			 * Decoder has the interface required by piranha::CodeDecodeTask. With more than one thread, the range of codes is split
+			 * in equal parts which are scanned and decoded concurrently. The decoded terms are then inserted in code order,
+			 * as in the single-threaded case.
+			 */
+			template <class Decoder>
+			void vectorDecodeAndInsert(Decoder const &decoder, std::size_t const nthread)
+			{
+				typedef typename Series1::TermType TermType;
+
+				const MaxFastInt lower  = m_fast_h.lower();
+				const MaxFastInt upper  = m_fast_h.upper() + 1;
+				const std::size_t ntask = nthread * tasksPerThread;
+
+				if (nthread == 1 || static_cast<double>(upper - lower) < static_cast<double>(ntask) * minDecodeRange)
+				{
+					ResultInserter<Decoder::uniqueTerms> inserter(*this);
+					decoder(lower, upper, inserter);
+					return;
+				}
+
+				stats::trace_stat("mult_mt: vector decode", std::size_t(0), increment);
+				std::vector<CodeDecodeTask<Decoder, TermType> > tasks;
+				tasks.reserve(ntask);
+				for (std::size_t i = 0; i < ntask; ++i)
+				{
+					tasks.push_back(CodeDecodeTask<Decoder, TermType>(decoder, lower + static_cast<MaxFastInt>((i * (upper - lower)) / ntask),
+					                                                  lower + static_cast<MaxFastInt>(((i + 1) * (upper - lower)) / ntask)));
+				}
+
+				WorkStealingExecutor executor(nthread);
+				executor.run(tasks);
+
+				std::size_t nterms = 0;
+				for (std::size_t i = 0; i < ntask; ++i)
+				{
+					nterms += tasks[i].m_terms.size();
+				}
+				reserveResult(nterms);
+
+				ResultInserter<Decoder::uniqueTerms> inserter(*this);
+				for (std::size_t i = 0; i < ntask; ++i)
+				{
+					for (std::size_t j = 0; j < tasks[i].m_terms.size(); ++j)
+					{
+						inserter.push_back(tasks[i].m_terms[j]);
+					}
+				}
+			}
+
+
+			/// Prepare the return value for receiving n more terms.
+			void reserveResult(std::size_t const n)
+			{
+				derived_cast->retval.reserveTerms(derived_cast->retval.length() + n);
+			}
+
+
+			/// Insert into the return value a decoded term which is known not to be there already.
+			/**
+			 * When the multiplication accumulates into a non-empty return value (see SeriesMultiplication::addmul_by_series()),
+			 * the term may be there already, and it is merged with the existing one.
+			 */
+			void insertUniqueResult(typename Series1::TermType const &term)
+			{
+				if (m_accumulate)
+				{
+					derived_cast->retval.insert(term, derived_const_cast->argsTuple);
+				} else
+				{
+					derived_cast->retval.insertUnique(term, derived_const_cast->argsTuple);
+				}
+			}
+
+
+			/// Adaptor inserting the terms pushed back by a decoder into the return value.
+			/**
+			 * Unique terms skip the duplicate lookup of piranha::BaseSeries::insert().
+			 */
+			template <bool Unique>
+			struct ResultInserter
+			{
+				explicit ResultInserter(CodedMultiplier &multiplier) : m_multiplier(multiplier) {}
+
+
+				void push_back(typename Series1::TermType const &term)
+				{
+					if (Unique)
+					{
+						m_multiplier.insertUniqueResult(term);
+					} else
+					{
+						static_cast<Derived &>(m_multiplier).retval.insert(term, static_cast<Derived &>(m_multiplier).argsTuple);
+					}
+				}
+
+
+				CodedMultiplier &m_multiplier;
+			};
+
+
+			/// Number of tasks of multi-threaded vector coded multiplication.
+			/**
+			 * N is the number of bytes of output per code. Beyond the tasksPerThread tasks per thread needed for load balancing,
+			 * the output range is split further so that the region of the output written by each task fits into the L2 cache.
+			 * No more than maxTasksPerThread tasks per thread are used, to bound the cost of the splitting.
+			 */
+			template <std::size_t N>
+			std::size_t vectorCodedTasks(std::size_t const nthread) const
+			{
+				const double cacheTasks = std::ceil((m_width * N) / (static_cast<double>(settings::get_cache_size(2)) * 1024));
+				const double minTasks   = static_cast<double>(nthread * tasksPerThread);
+				const double maxTasks   = static_cast<double>(nthread * maxTasksPerThread);
+
+				return static_cast<std::size_t>(std::min(maxTasks, std::max(minTasks, cacheTasks)));
+			}
+
+
+			/// Number of tasks per thread in multi-threaded coded multiplication.
+			/**
+			 * Having more tasks than threads lets piranha::WorkStealingExecutor balance the load when the
+			 * output ranges turn out to be uneven.
+			 */
+			static const std::size_t		tasksPerThread = 8;
+			/// Maximum number of tasks per thread in multi-threaded vector coded multiplication.
+			static const std::size_t		maxTasksPerThread = 64;
+			/// Minimum number of codes per task in multi-threaded decoding of vector coded results.
+			static const std::size_t		minDecodeRange = 4096;
 			/// Is global coded representation viable?
 			bool					m_gr_is_viable;
 			/// Multiprecision min/max values for the global representation.
@@ -765,10 +1199,174 @@ struct BaseCodedFunctor
 			std::vector<MaxFastInt>		m_ckeys2a;
 			/// Codes for the second series, minus.
 			std::vector<MaxFastInt>		m_ckeys2b;
+			/// Is the wide coding tier in use?
+			bool					m_wide;
+			/// Wide coding tuple.
+			wide_coding_tuple_type			m_wide_ct;
+			/// Wide decoding tuple.
+			wide_decoding_tuple_type		m_wide_dt;
+			/// Wide codes range, [m_wide_lower, m_wide_upper].
+			MaxWideInt				m_wide_lower;
+			MaxWideInt				m_wide_upper;
+			/// Wide codes for the first series.
+			std::vector<MaxWideInt>			m_wide_ckeys1;
+			/// Wide codes for the second series, plus.
+			std::vector<MaxWideInt>			m_wide_ckeys2a;
+			/// Wide codes for the second series, minus.
+			std::vector<MaxWideInt>			m_wide_ckeys2b;
+			/// Is split coding in use?
+			bool					m_split;
+			/// Coding tuples of the groups of split coding (zero for the variables outside the group).
+			std::vector<fast_coding_tuple_type>	m_split_ct;
+			/// Split decoding tuple.
+			split_decoding_tuple_type		m_split_dt;
+			/// Minimum code of each group of split coding.
+			std::vector<MaxFastInt>			m_split_min;
+			/// Number of codes in the range of the inner group of split coding.
+			MaxFastInt				m_split_width;
+			/// Split codes for the first series, per group.
+			std::vector<std::vector<MaxFastInt> >	m_split_ckeys1;
+			/// Split codes for the second series, plus, per group.
+			std::vector<std::vector<MaxFastInt> >	m_split_ckeys2a;
+			/// Split codes for the second series, minus, per group.
+			std::vector<std::vector<MaxFastInt> >	m_split_ckeys2b;
 			/// Density of the first series.
 			double					m_density1;
 			/// Density of the second series.
 			double					m_density2;
+			/// Number of codes in the range of the representation.
+			double					m_width;
+			/// Whether the results are accumulated into a non-empty return value.
+			const bool				m_accumulate;
+
+		private:
+			// Partition the variables into groups whose codes fit into MaxFastInt, and set up the coding and
+			// decoding of split coding. Variables are assigned greedily, in the order of the coding tuple.
+			// Return false if a single variable does not fit.
+			bool determineSplit()
+			{
+				typedef boost::numeric::interval<mp_integer> mp_interval;
+				const mp_integer maxFast(boost::lexical_cast<mp_integer>(std::numeric_limits<MaxFastInt>::max()));
+
+				std::vector<mp_interval> gr;
+				cm_tuple_flatten(m_mp_gr, gr);
+				const std::size_t size = gr.size();
+				std::vector<std::size_t> group(size);
+				std::vector<mp_integer> ct(size), width(size);
+				// Range of the codes of each group.
+				std::vector<mp_integer> lower, upper;
+				mp_integer prev(1);
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					width[i]  = boost::numeric::width(gr[i]);
+					width[i] += 1;
+					bool fits = false;
+					if (!lower.empty())
+					{
+						const mp_integer l(lower.back() + prev * gr[i].lower()), u(upper.back() + prev * gr[i].upper());
+						fits = (l >= -maxFast && u <= maxFast && u - l <= maxFast / 2);
+						if (fits)
+						{
+							lower.back() = l;
+							upper.back() = u;
+						}
+					}
+					if (!fits)
+					{
+						// Start a new group.
+						prev = 1;
+						if (gr[i].lower() < -maxFast || gr[i].upper() > maxFast || boost::numeric::width(gr[i]) > maxFast / 2)
+						{
+							return false;
+						}
+						lower.push_back(gr[i].lower());
+						upper.push_back(gr[i].upper());
+					}
+					group[i] = lower.size() - 1;
+					ct[i]    = prev;
+					prev    *= width[i];
+				}
+				PIRANHA_ASSERT(lower.size() > 1);
+
+				const std::size_t groups = lower.size();
+				std::vector<cm_split_decoding_entry> dt(size);
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					dt[i].group  = group[i];
+					dt[i].first  = boost::lexical_cast<MaxFastInt>(ct[i] * width[i]);
+					dt[i].second = boost::lexical_cast<MaxFastInt>(ct[i]);
+				}
+				cm_tuple_unflatten(dt, m_split_dt);
+
+				m_split_ct.resize(groups);
+				m_split_min.resize(groups);
+				for (std::size_t g = 0; g < groups; ++g)
+				{
+					std::vector<MaxFastInt> flat(size, 0);
+					for (std::size_t i = 0; i < size; ++i)
+					{
+						if (group[i] == g)
+						{
+							flat[i] = boost::lexical_cast<MaxFastInt>(ct[i]);
+						}
+					}
+					cm_init_vector_tuple<Series1>(m_split_ct[g], derived_const_cast->argsTuple);
+					cm_tuple_unflatten(flat, m_split_ct[g]);
+					m_split_min[g] = boost::lexical_cast<MaxFastInt>(lower[g]);
+				}
+				m_split_width = boost::lexical_cast<MaxFastInt>(upper[0] - lower[0]) + 1;
+
+				return true;
+			}
+
+
+			template <class CodingTuple, class Code>
+			void code_terms_impl(const CodingTuple &ct, std::vector<Code> &ckeys1, std::vector<Code> &ckeys2a, std::vector<Code> &ckeys2b)
+			{
+				// Establish if subtraction is requested or not.
+				static const bool sub_requested = op_has_sub<OpTuple>::value;
+				// Resize codes vectors.
+				typedef typename std::vector<Code>::size_type size_type;
+				const size_type csize1 = boost::numeric_cast<size_type>(derived_const_cast->terms1.size());
+				const size_type csize2 = boost::numeric_cast<size_type>(derived_const_cast->terms2.size());
+				ckeys1.resize(csize1);
+				ckeys2a.resize(csize2);
+				if (sub_requested) 
+				{
+					ckeys2b.resize(csize2);
+				}
+				// Now fill in the codes.
+				Code code_a = 0, code_b = 0;
+				for (size_type i = 0; i < csize1; ++i) 
+				{
+					cm_code<OpTuple>(ct, *derived_const_cast->terms1[i], m_vh, code_a, code_b);
+					ckeys1[i] = code_a;
+				}
+
+				for (size_type i = 0; i < csize2; ++i) 
+				{
+					cm_code<OpTuple>(ct, *derived_const_cast->terms2[i], m_vh, code_a, code_b);
+					ckeys2a[i] = code_a;
+					if (sub_requested) 
+					{
+						ckeys2b[i] = code_b;
+					}
+				}
+			}
+
+
+			template <class Code>
+			static void shiftCodesImpl(std::vector<Code> &ckeys, const Code chi)
+			{
+				typedef typename std::vector<Code>::size_type size_type;
+				const size_type size = ckeys.size();
+				for (size_type i = 0; i < size; ++i) 
+				{
+					ckeys[i] -= chi;
+
+					PIRANHA_ASSERT(ckeys[i] >= 0);
+				}
+			}
 	};
 }
 
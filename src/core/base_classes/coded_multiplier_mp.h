@@ -34,6 +34,10 @@
 #include <boost/numeric/interval.hpp>
 #include <boost/tuple/tuple.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
 #include <utility>
 #include <vector>
 #include <type_traits>
@@ -278,6 +282,14 @@ namespace piranha {
                 mp_rational     m_tmp;
         };
 
+        // Decoding information for one variable in split coded multiplication: the variable is decoded from
+        // the code of its group, using first and second as in the decoding tuple.
+        struct cm_split_decoding_entry {
+                std::size_t     group;
+                MaxFastInt      first;
+                MaxFastInt      second;
+        };
+
         // Define a type to hold the min/max values of array keys in series.
         template <class Series, int N>
         struct cm_tuple_impl {
@@ -304,6 +316,14 @@ namespace piranha {
                 // Decoding tuple: vectors of pairs of max_fast_ints, num and den resp. of the decoding formula.
                 typedef boost::tuples::cons<std::vector<std::pair<MaxFastInt,MaxFastInt> >,
                         typename cm_tuple_impl<typename Series::TermType::CfType, N - 1>::type_decoding_tuple> type_decoding_tuple;
+                // Wide coding and decoding tuples, used when the codes do not fit into MaxFastInt.
+                typedef boost::tuples::cons<std::vector<MaxWideInt>,
+                        typename cm_tuple_impl<typename Series::TermType::CfType, N - 1>::type_wide_coding_tuple> type_wide_coding_tuple;
+                typedef boost::tuples::cons<std::vector<std::pair<MaxWideInt,MaxWideInt> >,
+                        typename cm_tuple_impl<typename Series::TermType::CfType, N - 1>::type_wide_decoding_tuple> type_wide_decoding_tuple;
+                // Decoding tuple for split coded multiplication.
+                typedef boost::tuples::cons<std::vector<cm_split_decoding_entry>,
+                        typename cm_tuple_impl<typename Series::TermType::CfType, N - 1>::type_split_decoding_tuple> type_split_decoding_tuple;
         };
 
         template <class Series>
@@ -315,6 +335,9 @@ namespace piranha {
                 typedef boost::tuples::null_type type_mp_coding_tuple;
                 typedef boost::tuples::null_type type_coding_tuple;
                 typedef boost::tuples::null_type type_decoding_tuple;
+                typedef boost::tuples::null_type type_wide_coding_tuple;
+                typedef boost::tuples::null_type type_wide_decoding_tuple;
+                typedef boost::tuples::null_type type_split_decoding_tuple;
         };
 
         template <class Series>
@@ -326,6 +349,9 @@ namespace piranha {
                 typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_mp_coding_tuple type_mp_coding_tuple;
                 typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_coding_tuple type_coding_tuple;
                 typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_decoding_tuple type_decoding_tuple;
+                typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_wide_coding_tuple type_wide_coding_tuple;
+                typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_wide_decoding_tuple type_wide_decoding_tuple;
+                typedef typename cm_tuple_impl<Series, Series::echelonLevel + 1>::type_split_decoding_tuple type_split_decoding_tuple;
         };
 
         template <class Series, class Tuple>
@@ -358,6 +384,49 @@ namespace piranha {
         }
 
 
+        template <class Tuple>
+        struct cm_tuple_flatten_impl {
+                template <class T>
+                static void run(const Tuple &t, std::vector<T> &flat)
+                {
+                        flat.insert(flat.end(), t.get_head().begin(), t.get_head().end());
+                        cm_tuple_flatten_impl<typename Tuple::tail_type>::run(t.get_tail(), flat);
+                }
+                template <class T>
+                static void run_inverse(const T *flat, Tuple &t)
+                {
+                        std::copy(flat, flat + t.get_head().size(), t.get_head().begin());
+                        cm_tuple_flatten_impl<typename Tuple::tail_type>::run_inverse(flat + t.get_head().size(), t.get_tail());
+                }
+        };
+
+
+        template <>
+        struct cm_tuple_flatten_impl<boost::tuples::null_type> {
+                template <class T>
+                static void run(const boost::tuples::null_type &, std::vector<T> &) {}
+                template <class T>
+                static void run_inverse(const T *, const boost::tuples::null_type &) {}
+        };
+
+
+        // Concatenate the vectors of a tuple of vectors, from outwards to inwards in the echelon hierarchy.
+        template <class Tuple, class T>
+        inline void cm_tuple_flatten(const Tuple &t, std::vector<T> &flat)
+        {
+                flat.clear();
+                cm_tuple_flatten_impl<Tuple>::run(t, flat);
+        }
+
+
+        // Inverse of cm_tuple_flatten: the vectors of the tuple must already have the proper sizes.
+        template <class Tuple, class T>
+        inline void cm_tuple_unflatten(const std::vector<T> &flat, Tuple &t)
+        {
+                cm_tuple_flatten_impl<Tuple>::run_inverse(flat.empty() ? static_cast<const T *>(0) : &flat[0], t);
+        }
+
+
         template <class MinMaxTuple>
         struct cm_minmax2 {
                 template <class Series, class ValueHandlerTuple>
@@ -534,6 +603,31 @@ namespace piranha {
                 tuple_vector_dot_impl<Tuple1,Tuple2>::run(t1,t2,retval);
         }
 
+        // Convert a multiprecision integer into a MaxWideInt, from the limbs of the absolute value. The value must be within MaxWideInt's range.
+        inline MaxWideInt cm_mp_to_wide(const mp_integer &n)
+        {
+                const mpz_srcptr z = n.get_internal().get_mpz_t();
+                PIRANHA_ASSERT(mpz_sizeinbase(z, 2) <= std::size_t(maxWideIntDigits));
+                // Least significant 64 bit word first. The absolute value is below 2^127, hence two words are enough.
+                std::uint64_t words[2] = {0, 0};
+                std::size_t count = 0;
+                mpz_export(words, &count, -1, sizeof(std::uint64_t), 0, 0, z);
+                PIRANHA_ASSERT(count <= 2);
+                const MaxWideInt retval = (MaxWideInt(words[1]) << 64) + MaxWideInt(words[0]);
+                return (mpz_sgn(z) < 0) ? MaxWideInt(-retval) : retval;
+        }
+
+        // Largest value representable by MaxWideInt, in multiprecision.
+        inline mp_integer cm_max_wide()
+        {
+                mp_integer retval(1);
+                for (int i = 0; i < maxWideIntDigits; ++i) {
+                        retval *= 2;
+                }
+                retval -= 1;
+                return retval;
+        }
+
         template <class MpTuple>
         struct cm_mp_tuple_downcast_impl {
                 template <class FastTuple>
@@ -551,6 +645,15 @@ namespace piranha {
                                 fast_vector[i] = boost::lexical_cast<MaxFastInt>(mp_vector[i]);
                         }
                 }
+                static void run_impl(const std::vector<mp_integer> &mp_vector, std::vector<MaxWideInt> &wide_vector)
+                {
+                        typedef std::vector<mp_integer>::size_type size_type;
+                        const size_type size = mp_vector.size();
+                        PIRANHA_ASSERT(size == wide_vector.size());
+                        for (size_type i = 0; i < size; ++i) {
+                                wide_vector[i] = cm_mp_to_wide(mp_vector[i]);
+                        }
+                }
                 static void run_impl(const std::vector<boost::numeric::interval<mp_integer> > &mp_vector,
                         std::vector<boost::numeric::interval<MaxFastInt> > &fast_vector)
                 {
@@ -569,7 +672,7 @@ namespace piranha {
                 static void run(const boost::tuples::null_type &, const boost::tuples::null_type &) {}
         };
 
-        // Downcast a tuple of multiprecision integer (interval) vectors to tuple of MaxFastInt integer
+        // Downcast a tuple of multiprecision integer (interval) vectors to tuple of MaxFastInt (or MaxWideInt) integer
         // (interval) vectors.
         template <class MpTuple, class FastTuple>
         inline void cm_mp_tuple_downcast(const MpTuple &mp_tuple, FastTuple &fast_tuple)
@@ -590,16 +693,16 @@ namespace piranha {
 
         template <class OpTuple, bool SubRequested>
         struct cm_code_impl2 {
-                template <class CodingTuple, class Cf, class VhTuple>
-                static void run(const CodingTuple &ct, const Cf &cf, const VhTuple &vh_tuple, MaxFastInt &retval1, MaxFastInt &retval2)
+                template <class CodingTuple, class Cf, class VhTuple, class Code>
+                static void run(const CodingTuple &ct, const Cf &cf, const VhTuple &vh_tuple, Code &retval1, Code &retval2)
                 {
-            static_assert((std::is_same_v<typename CodingTuple::head_type::value_type,MaxFastInt>),"");
+            static_assert((std::is_same_v<typename CodingTuple::head_type::value_type,Code>),"");
                         PIRANHA_ASSERT(cf.length() == 1);
 
                         typedef typename Cf::TermType::KeyType::size_type size_type;
                         const size_type size = cf.begin()->key.size();
                         PIRANHA_ASSERT(size <= ct.get_head().size());
-                        MaxFastInt tmp = 0;
+                        Code tmp = 0;
 
             for (size_type i = 0; i < size; ++i)
             {
@@ -621,22 +724,22 @@ namespace piranha {
 
         template <bool SubRequested>
         struct cm_code_impl2<boost::tuples::null_type,SubRequested> {
-                template <class Cf>
-                static void run(const boost::tuples::null_type &, const Cf &, const boost::tuples::null_type &, const MaxFastInt &, const MaxFastInt &) {}
+                template <class Cf, class Code>
+                static void run(const boost::tuples::null_type &, const Cf &, const boost::tuples::null_type &, const Code &, const Code &) {}
         };
 
 
         template <class OpTuple>
         struct cm_code_impl1 {
-                template <class CodingTuple, class Term, class VhTuple>
-                static void run(const CodingTuple &ct, const Term &term, const VhTuple &vh_tuple, MaxFastInt &retval1, MaxFastInt &retval2)
+                template <class CodingTuple, class Term, class VhTuple, class Code>
+                static void run(const CodingTuple &ct, const Term &term, const VhTuple &vh_tuple, Code &retval1, Code &retval2)
                 {
-            static_assert((std::is_same_v<typename CodingTuple::head_type::value_type,MaxFastInt>),"");
+            static_assert((std::is_same_v<typename CodingTuple::head_type::value_type,Code>),"");
                         PIRANHA_ASSERT(term.key.size() <= ct.get_head().size());
 
                         static const bool sub_requested = op_has_sub<OpTuple>::value;
                         typedef typename Term::KeyType::size_type size_type;
-                        MaxFastInt tmp = 0;
+                        Code tmp = 0;
                         // NOTE: again the assumption that the sizes of vector and key are compatible. Need to sort this out...
                         for (size_type i = 0; i < term.key.size(); ++i)
             {
@@ -653,8 +756,9 @@ namespace piranha {
         };
 
         // Code term using provided operations tuple type, coding tuple, value handler tuple and appending result to vector of codes v_codes.
-        template <class OpTuple, class CodingTuple, class Term, class VhTuple>
-        inline void cm_code(const CodingTuple &ct, const Term &term, const VhTuple &vh_tuple, MaxFastInt &retval1, MaxFastInt &retval2)
+        // Code is MaxFastInt or, for the wide coding tier, MaxWideInt.
+        template <class OpTuple, class CodingTuple, class Term, class VhTuple, class Code>
+        inline void cm_code(const CodingTuple &ct, const Term &term, const VhTuple &vh_tuple, Code &retval1, Code &retval2)
         {
         static_assert(boost::tuples::length<OpTuple>::value == boost::tuples::length<CodingTuple>::value,"");
         static_assert(boost::tuples::length<OpTuple>::value == boost::tuples::length<VhTuple>::value,"");
@@ -666,8 +770,8 @@ namespace piranha {
 
         template <class DecodingTuple>
         struct cm_build_decoding_tuple_impl {
-                template <class MinMaxTuple>
-                static void run(MaxFastInt *prev_range, DecodingTuple &dt, const MinMaxTuple &minmax)
+                template <class MinMaxTuple, class Code>
+                static void run(Code *prev_range, DecodingTuple &dt, const MinMaxTuple &minmax)
                 {
                         typedef typename DecodingTuple::head_type::size_type size_type;
                         const size_type size = boost::numeric_cast<size_type>(minmax.get_head().size());
@@ -683,7 +787,8 @@ namespace piranha {
 
         template <>
         struct cm_build_decoding_tuple_impl<boost::tuples::null_type> {
-                static void run(MaxFastInt *, const boost::tuples::null_type &, const boost::tuples::null_type &) {}
+                template <class Code>
+                static void run(Code *, const boost::tuples::null_type &, const boost::tuples::null_type &) {}
         };
 
         // Build decoding tuple from global minmax representation.
@@ -691,17 +796,32 @@ namespace piranha {
         inline void cm_build_decoding_tuple(DecodingTuple &dt, const MinMaxTuple &minmax)
         {
         static_assert(boost::tuples::length<DecodingTuple>::value == boost::tuples::length<MinMaxTuple>::value,"");
-                MaxFastInt prev_range = 1;
+                typename DecodingTuple::head_type::value_type::first_type prev_range = 1;
                 cm_build_decoding_tuple_impl<DecodingTuple>::run(&prev_range,dt,minmax);
         }
 
+        // Value of a single variable, from a code and the variable's entry in the decoding tuple (without the minimum).
+        template <class Code>
+        inline MaxFastInt cm_decode_value(const std::pair<Code,Code> &d, const Code &code)
+        {
+                PIRANHA_ASSERT(code >= 0);
+                return static_cast<MaxFastInt>((code % d.first) / d.second);
+        }
+
+        // Same as above, for split coded multiplication: codes contains the code of each group of variables.
+        inline MaxFastInt cm_decode_value(const cm_split_decoding_entry &d, const std::vector<MaxFastInt> &codes)
+        {
+                PIRANHA_ASSERT(d.group < codes.size() && codes[d.group] >= 0);
+                return (codes[d.group] % d.first) / d.second;
+        }
+
         // This struct deals with coefficient series.
         template <class DecodingTuple>
         struct cm_decode_impl2
     {
-                template <class FinalCf, class MinMaxTuple, class Cf, class VhTuple, class ArgsTuple>
+                template <class FinalCf, class MinMaxTuple, class Cf, class VhTuple, class Code, class ArgsTuple>
                 static void run(const FinalCf &final_cf, const DecodingTuple &dt, const MinMaxTuple &gr, Cf &cf,
-                                const VhTuple &vh_tuple, const MaxFastInt &code, const ArgsTuple &argsTuple)
+                                const VhTuple &vh_tuple, const Code &code, const ArgsTuple &argsTuple)
                 {
             static_assert((std::is_base_of<BaseSeriesTag,Cf>::value),"");
                         typedef typename Cf::TermType term_type;
@@ -717,7 +837,7 @@ namespace piranha {
 
             for (size_type i = 0; i < size; ++i)
             {
-                                const MaxFastInt tmp = (code % dt.get_head()[i].first) / dt.get_head()[i].second +      gr.get_head()[i].lower();
+                                const MaxFastInt tmp = cm_decode_value(dt.get_head()[i], code) + gr.get_head()[i].lower();
 
                                 vh_tuple.get_head().post_decode(term.key[i], tmp);
                         }
@@ -734,9 +854,9 @@ namespace piranha {
         template <>
         struct cm_decode_impl2<boost::tuples::null_type>
     {
-                template <class Cf, class ArgsTuple>
+                template <class Cf, class Code, class ArgsTuple>
                 static void run(const Cf &final_cf, const boost::tuples::null_type &, const boost::tuples::null_type &, Cf &cf,
-                                const boost::tuples::null_type &, const MaxFastInt &, const ArgsTuple &)
+                                const boost::tuples::null_type &, const Code &, const ArgsTuple &)
                 {
                         // Last iteration simply assigns the final coefficient.
                         cf = final_cf;
@@ -748,11 +868,10 @@ namespace piranha {
     {
                 // NOTE: here the code is not the shifted one, it is supposed to have been shifted in
                 // the outside calling function.
-                template <class FinalCf, class MinMaxTuple, class Term, class VhTuple, class ArgsTuple>
+                template <class FinalCf, class MinMaxTuple, class Term, class VhTuple, class Code, class ArgsTuple>
                 static void run(const FinalCf &final_cf, const DecodingTuple &dt, const MinMaxTuple &gr, Term &term, const VhTuple &vh_tuple,
-                                const MaxFastInt &code, const ArgsTuple &argsTuple)
+                                const Code &code, const ArgsTuple &argsTuple)
                 {
-                        PIRANHA_ASSERT(code >= 0);
                         typedef typename Term::KeyType::size_type size_type;
                         // Make sure the sizes of the current tuples' elements are consistent.
                         // (De)coding tuple sizes should always be the same as args tuple's.
@@ -762,7 +881,7 @@ namespace piranha {
                         term.key.resize(size);
                         for (size_type i = 0; i < size; ++i)
             {
-                            const MaxFastInt tmp = (code % dt.get_head()[i].first) / dt.get_head()[i].second + gr.get_head()[i].lower();
+                            const MaxFastInt tmp = cm_decode_value(dt.get_head()[i], code) + gr.get_head()[i].lower();
 
                                 vh_tuple.get_head().post_decode(term.key[i], tmp);
                         }
@@ -773,15 +892,27 @@ namespace piranha {
 
 
         // Decode given code into term. final_cf is the last coefficient in the echelon hierarchy, from outwards to inwards.
-        template <class FinalCf, class DecodingTuple, class MinMaxTuple, class Term, class VhTuple, class ArgsTuple>
+        template <class FinalCf, class DecodingTuple, class MinMaxTuple, class Term, class VhTuple, class Code, class ArgsTuple>
         inline void cm_decode(const FinalCf &final_cf, const DecodingTuple &dt, const MinMaxTuple &gr, Term &term, const VhTuple &vh_tuple,
-                              const MaxFastInt &code, const MaxFastInt &min_code, const ArgsTuple &argsTuple)
+                              const Code &code, const Code &min_code, const ArgsTuple &argsTuple)
         {
         static_assert(boost::tuples::length<DecodingTuple>::value == boost::tuples::length<VhTuple>::value,"");
         static_assert(boost::tuples::length<DecodingTuple>::value == boost::tuples::length<MinMaxTuple>::value,"");
 
                 cm_decode_impl1<DecodingTuple>::run(final_cf, dt, gr, term, vh_tuple, code - min_code, argsTuple);
         }
+
+        // Decode into term the codes of the groups of variables of split coded multiplication. The codes must already
+        // have been shifted by the minimum codes of their groups.
+        template <class FinalCf, class DecodingTuple, class MinMaxTuple, class Term, class VhTuple, class ArgsTuple>
+        inline void cm_split_decode(const FinalCf &final_cf, const DecodingTuple &dt, const MinMaxTuple &gr, Term &term, const VhTuple &vh_tuple,
+                                    const std::vector<MaxFastInt> &codes, const ArgsTuple &argsTuple)
+        {
+        static_assert(boost::tuples::length<DecodingTuple>::value == boost::tuples::length<VhTuple>::value,"");
+        static_assert(boost::tuples::length<DecodingTuple>::value == boost::tuples::length<MinMaxTuple>::value,"");
+
+                cm_decode_impl1<DecodingTuple>::run(final_cf, dt, gr, term, vh_tuple, codes, argsTuple);
+        }
 }
 
 #endif
@@ -200,6 +200,8 @@ namespace piranha
 			template <class T>
 			Derived &operator*=(T const &);
 
+			Derived &addmul(Derived const &, Derived const &);
+
 			template <class T>
 			Derived &operator/=(T const &);
 
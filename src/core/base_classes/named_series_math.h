@@ -147,6 +147,39 @@ namespace piranha
 	}
 
 
+    //
+    // fused multiply-accumulate: this += series1 * series2, without building the product as a separate series.
+    // The arguments are merged as in operator*=(). The product is accumulated directly when this has the same
+    // arguments as series1 once merged, e.g., when accumulating several products of series with the same arguments.
+    // Otherwise the product is built and added.
+    //
+	template <PIRANHA_NAMED_SERIES_TP_DECL>
+	inline Derived & NamedSeries<PIRANHA_NAMED_SERIES_TP>::addmul(Derived const &series1, Derived const &series2)
+	{
+		if (!namedSeriesIsArgsCompatible(series1.arguments(), series2.arguments()))
+		{
+			Derived tmp(series1);
+			tmp.mergeArgs(series2);
+
+			return addmul(tmp, series2);
+		}
+
+		mergeArgs(series1);
+		if (argumentsTuple != series1.arguments())
+		{
+			Derived tmp(series1);
+			tmp *= series2;
+
+			return *derived_cast += tmp;
+		}
+
+		derived_cast->addmul_by_series(series1, series2, argumentsTuple);
+		trim(); // remove unused symbols
+
+		return *derived_cast;
+	}
+
+
     //
     // divide by x and trim result
     //
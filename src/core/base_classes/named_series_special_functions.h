@@ -233,13 +233,12 @@ namespace piranha
 					for (int t = std::max<int>(0,k-m); t <= std::min<int>(n-m,n+k); ++t) 
                     {
 						Derived tmp3(ccb2[n*2-m+k-t*2]);
-						tmp3 *= csb2[m-k+t*2];
 						tmp3 *= cs_phase(t);
 						tmp3 /= factorial(t);
 						tmp3 /= factorial(n+k-t);
 						tmp3 /= factorial(n-m-t);
 						tmp3 /= factorial(m-k+t);
-						tmp2 += tmp3;
+						tmp2.addmul(tmp3, csb2[m-k+t*2]);
 					}
 
 					tmp *= tmp2;
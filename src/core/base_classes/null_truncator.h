@@ -22,6 +22,7 @@
 #define PIRANHA_NULL_TRUNCATOR_H
 
 #include "../exceptions.h"
+#include "../mp.h"
 
 #include <vector>
 
@@ -57,6 +58,13 @@ namespace piranha
 					}
 
 
+					template <class Series, class ArgsTuple2>
+					static mp_rational powerSeriesOrder(Series const &, ArgsTuple2 const &)
+					{
+						PIRANHA_THROW(value_error, "null truncator cannot provide the order of a power series.");
+					}
+
+
 					bool isEffective() const
 					{
 						return false;
@@ -21,6 +21,7 @@
 #define PIRANHA_SERIES_MULTIPLICATION_H
 
 #include "../config.h"
+#include "../mp.h"
 #include "../settings.h"
 
 #include <cstddef>
@@ -54,6 +55,14 @@ namespace piranha
 			}
 
 
+			// Order of the series as seen by the truncator, e.g., its minimum partial degree under partial degree truncation.
+			template <class ArgsTuple>
+			mp_rational psOrder(ArgsTuple const &argsTuple) const
+			{
+				return Multiplier::template get_type<Derived, Derived, ArgsTuple, Truncator>::truncator_type::powerSeriesOrder(*derived_const_cast, argsTuple);
+			}
+
+
 			template <class Series, class ArgsTuple>
 			std::vector<typename Series::TermType const *> get_sorted_series(const ArgsTuple &argsTuple) const
 			{
@@ -115,6 +124,34 @@ namespace piranha
 					//std::cout << "series_multiplication::multiply by_series  : 3" << std::endl << std::flush;
 				}
 			}
+
+
+			// Multiply series1 by series2 term-by-term and accumulate the result into this, without
+			// building the product as a separate series first.
+			// Preconditions: same as multiply_by_series(), for both series1 and series2.
+			template <class Derived2, class ArgsTuple>
+			void addmul_by_series(const Derived &series1, const Derived2 &series2, const ArgsTuple &argsTuple)
+			{
+				if (series1.empty() || series2.empty())
+				{
+					return;
+				}
+
+				// The multipliers read the input series while writing into the result, hence the result cannot
+				// be one of the inputs. Single coefficient series are multiplied without multiplier anyway.
+				if (static_cast<void const *>(derived_const_cast) == static_cast<void const *>(&series1)
+					|| static_cast<void const *>(derived_const_cast) == static_cast<void const *>(&series2)
+					|| (settings::getMultiplicationAlgorithm() == settings::MultiplicationAlgorithm::AUTOMATIC && (series1.isSingleCf() || series2.isSingleCf())))
+				{
+					Derived tmp(series1);
+					tmp.multiply_by_series(series2, argsTuple);
+					derived_cast->baseAdd(tmp, argsTuple);
+					return;
+				}
+
+				typename Multiplier::template get_type<Derived, Derived2, ArgsTuple, Truncator> multiplier(series1, series2, *derived_cast, argsTuple);
+				multiplier.performMultiplication();
+			}
 	};
 }
 
@@ -30,6 +30,7 @@
 #include "../exceptions.h"
 #include "../memory.h"
 #include "../Psym.h"
+#include "../small_vector.h"
 
 #include <cstddef>
 #include <iostream>
@@ -45,11 +46,15 @@ namespace piranha
 	/// Vector key.
 	/**
 	 * Series key type that can be represented as a vector of values.
+	 *
+	 * Up to InlineSize values are stored inside the key itself (see piranha::SmallVector), so that short keys need no memory allocation
+	 * when they are created, copied and destroyed. Longer keys spill to memory obtained from piranha::CountingAllocator.
 	 */
 	// T: type of key elements e.g boost::int16_t
 	// Position: echelon level, determines which key it is. Each level has it's own key
 	// Derived:  Derived class, for CRTP, static polymorphism
-	template <class T, unsigned int Position, class Derived> 
+	// InlineSize: number of elements stored without allocation. 0 stores all elements on the heap.
+	template <class T, unsigned int Position, class Derived, std::size_t InlineSize = 0>
 	class VectorKey
 	{
 #ifdef DEBUG
@@ -59,7 +64,7 @@ namespace piranha
 
 			// The index into the vector is the same as into the argDescr. This is how the the symbols get
 		    // connected to the related numeric factors/exponents
-		using ContainerType = std::vector<T, CountingAllocator<T> >;
+		using ContainerType = SmallVector<T, InlineSize, CountingAllocator<T> >;
 
 		public:
 
@@ -90,11 +95,17 @@ namespace piranha
 			// Copy ctor.
 			VectorKey(const VectorKey &other): container(other.container) {}
 
+			// Move ctor. Cheap and non-throwing for integral elements, so that flat term containers move the keys when they grow.
+			VectorKey(VectorKey &&other) noexcept(std::is_nothrow_move_constructible<ContainerType>::value): container(std::move(other.container)) {}
+
+			VectorKey &operator=(const VectorKey &) = default;
+			VectorKey &operator=(VectorKey &&) = default;
+
 
 			/// Copy ctor, different position..
             // what is that good for? Used anywhere except in defintiion of TrigVector?
 			template <int Position2, class Derived2>
-			VectorKey(const VectorKey<T, Position2, Derived2> &other): container(other.container) {}
+			VectorKey(const VectorKey<T, Position2, Derived2, InlineSize> &other): container(other.container) {}
 
 
 			// Construct from Psym. ??
@@ -334,7 +345,7 @@ namespace piranha
 				}
 
 				// Now we are certain that the size is at least 1, extract pointer to first element.
-				// C++ standard guarantees that elements in std::vector are in contiguous memory areas.
+				// The elements of the container are in contiguous memory areas.
 				const value_type *ptr1 = &container[0];
                 const value_type *ptr2 = &(v2.container[0]);
 				for (size_type i = size; i > 0; --i) 
@@ -29,6 +29,7 @@
 
 #include "config.h"
 #include "exceptions.h"
+#include "integer_typedefs.h"
 #include "settings.h"
 
 #include <cstddef>
@@ -45,6 +46,31 @@ namespace piranha
 // TODO: make sure the size of the vector never goes past MaxFastInt, since we are converting size_type -> MaxFastInt in the hash coded
 // multiplier, when determining the memory position of the key.
 
+/// Hash functor for the codes stored in coded_hash_table.
+/**
+ * Defaults to boost::hash.
+ */
+template <class Code>
+struct coded_hash: boost::hash<Code> {};
+
+#if defined(__SIZEOF_INT128__)
+/// Hash functor for native 128-bit codes.
+/**
+ * boost::hash does not know about the native 128-bit integer, hence the low and high halves are combined.
+ */
+template <>
+struct coded_hash<MaxWideInt>
+{
+        std::size_t operator()(const MaxWideInt &code) const
+        {
+                const unsigned __int128 u = static_cast<unsigned __int128>(code);
+                std::size_t retval = static_cast<std::size_t>(static_cast<std::uint64_t>(u & ~std::uint64_t(0)));
+                boost::hash_combine(retval, static_cast<std::uint64_t>(u >> 64));
+                return retval;
+        }
+};
+#endif
+
 /// Hash table for highly-sparse coded series multiplication.
 template <class Cf, class Code, class Allocator>
 class coded_hash_table
@@ -193,6 +219,28 @@ class coded_hash_table
                         m_size_policy(pow2),m_size_index(find_upper_size_index(size_hint / bucket_size + 1)),m_length(0),
                         m_container(boost::numeric_cast<size_type>(sizes[m_size_policy][m_size_index]))
                 {}
+                /// Constructor with allocator.
+                /**
+                 * Sets the size policy to pow2. The table and its resized versions draw memory from the provided allocator.
+                 *
+                 * @param[in] allocator allocator of the hash table.
+                 */
+                explicit coded_hash_table(const Allocator &allocator): m_size_policy(pow2),m_size_index(min_size_index),m_length(0),
+                        m_container(boost::numeric_cast<size_type>(sizes[m_size_policy][m_size_index]),bucket_type(),
+                        typename container_type::allocator_type(allocator))
+                {}
+                /// Constructor with size hint and allocator.
+                /**
+                 * As the constructor with size hint, drawing memory from the provided allocator.
+                 *
+                 * @param[in] size_hint size hint for the hash table.
+                 * @param[in] allocator allocator of the hash table.
+                 */
+                coded_hash_table(const std::size_t &size_hint, const Allocator &allocator):
+                        m_size_policy(pow2),m_size_index(find_upper_size_index(size_hint / bucket_size + 1)),m_length(0),
+                        m_container(boost::numeric_cast<size_type>(sizes[m_size_policy][m_size_index]),bucket_type(),
+                        typename container_type::allocator_type(allocator))
+                {}
                 /// Destructor.
                 ~coded_hash_table()
                 {
@@ -234,7 +282,7 @@ class coded_hash_table
                 std::pair<bool,iterator> find(const KeyType &key)
                 {
                         const size_type vector_size = m_container.size(),
-                                vector_pos = get_position(boost::hash<KeyType>()(key),vector_size,m_size_policy);
+                                vector_pos = get_position(coded_hash<KeyType>()(key),vector_size,m_size_policy);
                         PIRANHA_ASSERT(vector_pos < vector_size);
                         const bucket_type &bucket = m_container[vector_pos];
                         // Now examine all elements in the bucket.
@@ -303,7 +351,7 @@ class coded_hash_table
                 /// Get memory position in which key would be inserted, relative to the table's starting point.
                 size_type get_memory_position(const KeyType &key) const
                 {
-                        return get_position(boost::hash<KeyType>()(key),m_container.size(),m_size_policy);
+                        return get_position(coded_hash<KeyType>()(key),m_container.size(),m_size_policy);
                 }
                 /// Return the size of the vector representing the hash table internally.
                 size_type get_vector_size() const
@@ -358,7 +406,7 @@ class coded_hash_table
                 bool unchecked_insertion(const value_type &v)
                 {
                         const size_type vector_size = m_container.size(),
-                                vector_pos = get_position(boost::hash<KeyType>()(v.second),vector_size,m_size_policy);
+                                vector_pos = get_position(coded_hash<KeyType>()(v.second),vector_size,m_size_policy);
                         PIRANHA_ASSERT(vector_pos < vector_size);
                         bucket_type &bucket = m_container[vector_pos];
                         // Now check for an available slot in the bucket.
@@ -402,7 +450,7 @@ class coded_hash_table
                                 PIRANHA_DEBUG(std::cout << "Load factor too low in pow2 sizes, switching to prime sizes.\n";)
                                 new_size_policy = prime;
                         }
-                        coded_hash_table new_ht;
+                        coded_hash_table new_ht(Allocator(m_container.get_allocator()));
                         new_ht.m_size_policy = new_size_policy;
                         new_ht.m_size_index = m_size_index + 2;
                         new_ht.m_length = 0;
@@ -0,0 +1,171 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_FFT_H
+#define PIRANHA_FFT_H
+
+#include <boost/math/constants/constants.hpp>
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "exceptions.h"
+
+namespace piranha
+{
+	/// Convolution of real sequences through the fast Fourier transform.
+	/**
+	 * The convolution of sequences of lengths n1 and n2 costs O(N log N) operations, N being the smallest power of two
+	 * not less than n1 + n2 - 1, against the n1 * n2 operations of the direct product.
+	 *
+	 * The transform is an iterative radix-2 one, with twiddle factors evaluated directly rather than by recurrence.
+	 * Then the absolute error of each element of the convolution of a and b is bounded by
+	 *
+	 * c * log2(N) * eps * |a|_2 * |b|_2,
+	 *
+	 * eps being the machine epsilon and |.|_2 the Euclidean norm (Percival, "Rapid multiplication modulo the sum
+	 * and difference of highly composite numbers", 2003). errorBound() evaluates this bound, with a safety margin on the constant c.
+	 */
+	class FFT
+	{
+		public:
+
+			typedef std::complex<double> Complex;
+
+
+			/// Transform length for the convolution of sequences of lengths n1 and n2.
+			static std::size_t length(std::size_t const n1, std::size_t const n2)
+			{
+				PIRANHA_ASSERT(n1 > 0 && n2 > 0);
+				std::size_t retval = 1;
+				while (retval < n1 + n2 - 1)
+				{
+					retval <<= 1;
+				}
+				return retval;
+			}
+
+
+			/// Bound of the absolute error on the elements of the convolution.
+			/**
+			 * n is the transform length, norm1 and norm2 the Euclidean norms of the convolved sequences.
+			 */
+			static double errorBound(std::size_t const n, double const norm1, double const norm2)
+			{
+				return 8 * (std::log2(static_cast<double>(n)) + 1) * std::numeric_limits<double>::epsilon() * norm1 * norm2;
+			}
+
+
+			/// Convolution of the real sequences a and b, stored into c.
+			/**
+			 * Both sequences are packed into one complex sequence, so that the convolution takes one direct and one inverse transform.
+			 */
+			static void convolution(std::vector<double> const &a, std::vector<double> const &b, std::vector<double> &c)
+			{
+				PIRANHA_ASSERT(a.size() > 0 && b.size() > 0);
+				const std::size_t n = length(a.size(), b.size());
+				std::vector<Complex> z(n);
+				for (std::size_t i = 0; i < a.size(); ++i)
+				{
+					z[i].real(a[i]);
+				}
+				for (std::size_t i = 0; i < b.size(); ++i)
+				{
+					z[i].imag(b[i]);
+				}
+
+				const std::vector<Complex> w = twiddles(n);
+				transform(z, w, false);
+
+				// Untangle the transforms of a and b, and multiply them.
+				std::vector<Complex> product(n);
+				for (std::size_t k = 0; k < n; ++k)
+				{
+					const Complex zk  = z[k];
+					const Complex znk = std::conj(z[(n - k) & (n - 1)]);
+					const Complex ak  = (zk + znk) * 0.5;
+					const Complex bk  = (zk - znk) * Complex(0, -0.5);
+					product[k] = ak * bk;
+				}
+
+				transform(product, w, true);
+				c.resize(a.size() + b.size() - 1);
+				for (std::size_t i = 0; i < c.size(); ++i)
+				{
+					c[i] = product[i].real() / static_cast<double>(n);
+				}
+			}
+
+		private:
+
+			// exp(-2 pi i k / n) for k in [0, n / 2[.
+			static std::vector<Complex> twiddles(std::size_t const n)
+			{
+				std::vector<Complex> retval(n / 2);
+				for (std::size_t k = 0; k < retval.size(); ++k)
+				{
+					retval[k] = std::polar(1., -2 * boost::math::constants::pi<double>() * static_cast<double>(k) / static_cast<double>(n));
+				}
+				return retval;
+			}
+
+
+			// In place transform of z, whose size is a power of two. The inverse transform is not normalised.
+			static void transform(std::vector<Complex> &z, std::vector<Complex> const &w, bool const inverse)
+			{
+				const std::size_t n = z.size();
+				// Bit reversal permutation.
+				for (std::size_t i = 1, j = 0; i < n; ++i)
+				{
+					std::size_t bit = n >> 1;
+					for (; j & bit; bit >>= 1)
+					{
+						j ^= bit;
+					}
+					j ^= bit;
+					if (i < j)
+					{
+						std::swap(z[i], z[j]);
+					}
+				}
+
+				for (std::size_t len = 2; len <= n; len <<= 1)
+				{
+					const std::size_t half   = len >> 1;
+					const std::size_t stride = n / len;
+					for (std::size_t i = 0; i < n; i += len)
+					{
+						for (std::size_t k = 0; k < half; ++k)
+						{
+							const Complex t = (inverse ? std::conj(w[k * stride]) : w[k * stride]) * z[i + k + half];
+							z[i + k + half] = z[i + k] - t;
+							z[i + k]       += t;
+						}
+					}
+				}
+			}
+	};
+}
+
+#endif
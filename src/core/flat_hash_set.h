@@ -0,0 +1,569 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef PIRANHA_FLAT_HASH_SET_H
+#define PIRANHA_FLAT_HASH_SET_H
+
+#include <boost/functional/hash.hpp>
+#include <boost/iterator/iterator_categories.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include "config.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace piranha
+{
+	/// Open addressing hash set, storing its elements inline.
+	/**
+	 * The elements live in one flat array of slots, next to an array of control bytes. A control byte tells whether
+	 * its slot is empty, deleted or full; for full slots it also holds 7 bits of the hash of the element, so that probing
+	 * compares elements only when these bits match. Collisions are resolved by linear probing, and the load factor,
+	 * deleted slots included, is kept below 7/8. Compared to a node based set there is no allocation per element,
+	 * no pointer chasing during lookups and iteration scans contiguous memory.
+	 *
+	 * Erasing an element leaves the other ones in place, hence erasure invalidates only the iterators to the erased element.
+	 * Insertions which make the table grow (see reserve()) move all the elements and invalidate all iterators.
+	 *
+	 * Elements are const from the point of view of the set: parts of them not involved in hashing and comparison can
+	 * be declared mutable and modified in place, as done for the coefficients of series terms.
+	 */
+	template <class Value, class Hash = boost::hash<Value>, class Equal = std::equal_to<Value>, class Allocator = std::allocator<Value> >
+	class FlatHashSet
+	{
+			typedef unsigned char ControlType;
+
+			// Control bytes. Full slots hold 7 bits of the hash, i.e., values below EMPTY.
+			static constexpr ControlType EMPTY    = 0x80;
+			static constexpr ControlType DELETED  = 0xfe;
+			static constexpr ControlType SENTINEL = 0xff;
+
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Value>       ValueAllocator;
+			typedef typename std::allocator_traits<Allocator>::template rebind_alloc<ControlType> ControlAllocator;
+			typedef std::allocator_traits<ValueAllocator>                                           ValueTraits;
+			typedef std::allocator_traits<ControlAllocator>                                         ControlTraits;
+
+		public:
+
+			typedef Value       value_type;
+			typedef Value       key_type;
+			typedef std::size_t size_type;
+			typedef Hash        hasher;
+			typedef Equal       key_equal;
+
+			/// Const iterator.
+			/**
+			 * The control bytes end with a sentinel, so that incrementing stops at the end of the table without bounds checks.
+			 */
+			class const_iterator: public boost::iterator_facade<const_iterator, const Value, boost::forward_traversal_tag>
+			{
+					friend class boost::iterator_core_access;
+					friend class FlatHashSet;
+
+					const_iterator(ControlType const *control, Value const *slot): m_control(control), m_slot(slot) {}
+
+				public:
+
+					const_iterator(): m_control(0), m_slot(0) {}
+
+				private:
+
+					Value const &dereference() const
+					{
+						PIRANHA_ASSERT(m_control && *m_control < EMPTY);
+						return *m_slot;
+					}
+
+
+					bool equal(const_iterator const &other) const
+					{
+						return m_control == other.m_control;
+					}
+
+
+					// Move to the next full slot, or to the sentinel.
+					void increment()
+					{
+						do
+						{
+							++m_control;
+							++m_slot;
+						} while (*m_control >= EMPTY && *m_control != SENTINEL);
+					}
+
+
+					ControlType const *m_control;
+					Value const       *m_slot;
+			};
+
+			typedef const_iterator iterator;
+
+
+			FlatHashSet(): m_slots(0), m_control(emptyControl()), m_capacity(0), m_size(0), m_deleted(0) {}
+
+
+			FlatHashSet(FlatHashSet const &other): m_slots(0), m_control(emptyControl()), m_capacity(0), m_size(0), m_deleted(0),
+				m_hash(other.m_hash), m_equal(other.m_equal),
+				m_valueAllocator(ValueTraits::select_on_container_copy_construction(other.m_valueAllocator)),
+				m_controlAllocator(ControlTraits::select_on_container_copy_construction(other.m_controlAllocator))
+			{
+				if (other.m_size == 0)
+				{
+					return;
+				}
+
+				// Same capacity, hence the elements can keep their slots.
+				allocate(other.m_capacity);
+				size_type i = 0;
+				try {
+					for (; i < m_capacity; ++i)
+					{
+						if (other.m_control[i] < EMPTY)
+						{
+							ValueTraits::construct(m_valueAllocator, m_slots + i, other.m_slots[i]);
+						}
+						m_control[i] = other.m_control[i];
+					}
+				} catch (...)
+				{
+					for (size_type j = 0; j < i; ++j)
+					{
+						if (m_control[j] < EMPTY)
+						{
+							ValueTraits::destroy(m_valueAllocator, m_slots + j);
+						}
+					}
+					deallocate();
+					throw;
+				}
+				m_size    = other.m_size;
+				m_deleted = other.m_deleted;
+			}
+
+
+			FlatHashSet(FlatHashSet &&other) noexcept: m_slots(other.m_slots), m_control(other.m_control), m_capacity(other.m_capacity),
+				m_size(other.m_size), m_deleted(other.m_deleted), m_hash(std::move(other.m_hash)), m_equal(std::move(other.m_equal)),
+				m_valueAllocator(std::move(other.m_valueAllocator)), m_controlAllocator(std::move(other.m_controlAllocator))
+			{
+				other.m_slots    = 0;
+				other.m_control  = emptyControl();
+				other.m_capacity = 0;
+				other.m_size     = 0;
+				other.m_deleted  = 0;
+			}
+
+
+			~FlatHashSet()
+			{
+				destroyAll();
+				deallocate();
+			}
+
+
+			FlatHashSet &operator=(FlatHashSet const &other)
+			{
+				if (this != &other)
+				{
+					FlatHashSet tmp(other);
+					swap(tmp);
+				}
+				return *this;
+			}
+
+
+			FlatHashSet &operator=(FlatHashSet &&other) noexcept
+			{
+				if (this != &other)
+				{
+					FlatHashSet tmp(std::move(other));
+					swap(tmp);
+				}
+				return *this;
+			}
+
+
+			const_iterator begin() const
+			{
+				const_iterator retval(m_control, m_slots);
+				if (*m_control >= EMPTY && *m_control != SENTINEL)
+				{
+					retval.increment();
+				}
+				return retval;
+			}
+
+
+			const_iterator end() const
+			{
+				return const_iterator(m_control + m_capacity, m_slots + m_capacity);
+			}
+
+
+			size_type size() const
+			{
+				return m_size;
+			}
+
+
+			bool empty() const
+			{
+				return m_size == 0;
+			}
+
+
+			/// Number of slots.
+			size_type capacity() const
+			{
+				return m_capacity;
+			}
+
+
+			const_iterator find(Value const &value) const
+			{
+				if (m_size == 0)
+				{
+					return end();
+				}
+
+				const std::size_t hash = mix(m_hash(value));
+				const ControlType tag  = tagOf(hash);
+				for (size_type i = hash & (m_capacity - 1); ; i = (i + 1) & (m_capacity - 1))
+				{
+					const ControlType control = m_control[i];
+					if (control == tag && m_equal(m_slots[i], value))
+					{
+						return const_iterator(m_control + i, m_slots + i);
+					}
+					if (control == EMPTY)
+					{
+						return end();
+					}
+				}
+			}
+
+
+			/// Insert value, if not present already.
+			/**
+			 * Returns the position of the element equal to value, and whether the insertion took place.
+			 */
+			std::pair<const_iterator, bool> insert(Value const &value)
+			{
+				return emplaceImpl(value);
+			}
+
+
+			std::pair<const_iterator, bool> insert(Value &&value)
+			{
+				return emplaceImpl(std::move(value));
+			}
+
+
+			/// Insert value, known not to be present.
+			/**
+			 * The value goes to the first empty or deleted slot of its probe sequence, without comparing it to the elements
+			 * met along the way. Inserting a value already present breaks the set.
+			 */
+			const_iterator insertUnique(Value const &value)
+			{
+				PIRANHA_ASSERT(find(value) == end());
+				const std::size_t hash = mix(m_hash(value));
+				const size_type target = placeImpl(hash, m_capacity ? freeSlot(hash) : m_capacity, value);
+				return const_iterator(m_control + target, m_slots + target);
+			}
+
+
+			/// Erase the element at it.
+			/**
+			 * Returns the iterator to the next element. The other elements are not moved.
+			 */
+			const_iterator erase(const_iterator it)
+			{
+				PIRANHA_ASSERT(it != end() && *it.m_control < EMPTY);
+				const size_type i = static_cast<size_type>(it.m_control - m_control);
+				ValueTraits::destroy(m_valueAllocator, m_slots + i);
+				// If the next slot is empty no probe sequence goes through this slot, which can then become empty too.
+				if (m_control[(i + 1) & (m_capacity - 1)] == EMPTY)
+				{
+					m_control[i] = EMPTY;
+				} else
+				{
+					m_control[i] = DELETED;
+					++m_deleted;
+				}
+				--m_size;
+				it.increment();
+				return it;
+			}
+
+
+			size_type erase(Value const &value)
+			{
+				const const_iterator it = find(value);
+				if (it == end())
+				{
+					return 0;
+				}
+				erase(it);
+				return 1;
+			}
+
+
+			/// Prepare the set for holding n elements without further growth.
+			void reserve(size_type const n)
+			{
+				const size_type capacity = capacityFor(n);
+				if (capacity > m_capacity)
+				{
+					rehash(capacity);
+				}
+			}
+
+
+			/// Destroy all the elements. The capacity is retained.
+			void clear()
+			{
+				destroyAll();
+				std::fill(m_control, m_control + m_capacity, EMPTY);
+				m_size    = 0;
+				m_deleted = 0;
+			}
+
+
+			void swap(FlatHashSet &other)
+			{
+				std::swap(m_slots, other.m_slots);
+				std::swap(m_control, other.m_control);
+				std::swap(m_capacity, other.m_capacity);
+				std::swap(m_size, other.m_size);
+				std::swap(m_deleted, other.m_deleted);
+				std::swap(m_hash, other.m_hash);
+				std::swap(m_equal, other.m_equal);
+				std::swap(m_valueAllocator, other.m_valueAllocator);
+				std::swap(m_controlAllocator, other.m_controlAllocator);
+			}
+
+		private:
+
+			// Control bytes of the table without slots: just the sentinel. It is never written.
+			static ControlType *emptyControl()
+			{
+				static ControlType retval[1] = {SENTINEL};
+				return retval;
+			}
+
+
+			// Spread the bits of the hash, so that both the low bits (the slot) and the high bits (the tag) depend on all of them.
+			static std::size_t mix(std::size_t const hash)
+			{
+				const std::uint64_t h = static_cast<std::uint64_t>(hash) * UINT64_C(0x9e3779b97f4a7c15);
+				return static_cast<std::size_t>(h ^ (h >> 32));
+			}
+
+
+			static ControlType tagOf(std::size_t const hash)
+			{
+				return static_cast<ControlType>((static_cast<std::uint64_t>(hash) >> 57) & 0x7f);
+			}
+
+
+			// Smallest power of two capacity holding n elements below the maximum load factor.
+			static size_type capacityFor(size_type const n)
+			{
+				if (n == 0)
+				{
+					return 0;
+				}
+				size_type retval = 8;
+				while (retval / 8 * 7 < n)
+				{
+					retval <<= 1;
+				}
+				return retval;
+			}
+
+
+			template <class V>
+			std::pair<const_iterator, bool> emplaceImpl(V &&value)
+			{
+				const std::size_t hash = mix(m_hash(value));
+				const ControlType tag  = tagOf(hash);
+				// Look for the value, remembering the first reusable slot along the probe sequence.
+				size_type target = m_capacity;
+				if (m_capacity)
+				{
+					for (size_type i = hash & (m_capacity - 1); ; i = (i + 1) & (m_capacity - 1))
+					{
+						const ControlType control = m_control[i];
+						if (control == tag && m_equal(m_slots[i], value))
+						{
+							return std::make_pair(const_iterator(m_control + i, m_slots + i), false);
+						}
+						if (control == DELETED && target == m_capacity)
+						{
+							target = i;
+						}
+						if (control == EMPTY)
+						{
+							if (target == m_capacity)
+							{
+								target = i;
+							}
+							break;
+						}
+					}
+				}
+
+				target = placeImpl(hash, target, std::forward<V>(value));
+				return std::make_pair(const_iterator(m_control + target, m_slots + target), true);
+			}
+
+
+			// Construct value in the free slot target of the probe sequence of hash, or in a new free slot if the table
+			// has no room for it (target equal to the capacity included). Returns the slot used.
+			template <class V>
+			size_type placeImpl(std::size_t const hash, size_type target, V &&value)
+			{
+				// Filling an empty slot consumes the margin to the maximum load factor, reusing a deleted one does not.
+				if (target == m_capacity || (m_control[target] == EMPTY && (m_size + m_deleted + 1) > m_capacity / 8 * 7))
+				{
+					// Grow if the elements alone need it, otherwise just get rid of the deleted slots.
+					rehash(std::max(capacityFor(m_size + 1), (m_size + 1) > m_capacity / 16 * 7 ? m_capacity * 2 : m_capacity));
+					target = freeSlot(hash);
+				}
+
+				ValueTraits::construct(m_valueAllocator, m_slots + target, std::forward<V>(value));
+				if (m_control[target] == DELETED)
+				{
+					--m_deleted;
+				}
+				m_control[target] = tagOf(hash);
+				++m_size;
+				return target;
+			}
+
+
+			// First empty or deleted slot in the probe sequence of hash.
+			size_type freeSlot(std::size_t const hash) const
+			{
+				PIRANHA_ASSERT(m_capacity > 0);
+				size_type i = hash & (m_capacity - 1);
+				while (m_control[i] < EMPTY)
+				{
+					i = (i + 1) & (m_capacity - 1);
+				}
+				return i;
+			}
+
+
+			// Move the elements into a table of the given capacity, dropping the deleted slots.
+			void rehash(size_type const capacity)
+			{
+				PIRANHA_ASSERT(capacity >= 8 && (capacity & (capacity - 1)) == 0 && capacity / 8 * 7 >= m_size);
+				FlatHashSet tmp;
+				tmp.m_valueAllocator   = m_valueAllocator;
+				tmp.m_controlAllocator = m_controlAllocator;
+				tmp.allocate(capacity);
+				for (size_type i = 0; i < m_capacity; ++i)
+				{
+					if (m_control[i] < EMPTY)
+					{
+						const std::size_t hash = mix(m_hash(m_slots[i]));
+						const size_type j = tmp.freeSlot(hash);
+						ValueTraits::construct(tmp.m_valueAllocator, tmp.m_slots + j, std::move_if_noexcept(m_slots[i]));
+						tmp.m_control[j] = m_control[i];
+						++tmp.m_size;
+					}
+				}
+				std::swap(m_slots, tmp.m_slots);
+				std::swap(m_control, tmp.m_control);
+				std::swap(m_capacity, tmp.m_capacity);
+				std::swap(m_size, tmp.m_size);
+				std::swap(m_deleted, tmp.m_deleted);
+			}
+
+
+			// Allocate the slots and the control bytes for an empty table.
+			void allocate(size_type const capacity)
+			{
+				PIRANHA_ASSERT(m_capacity == 0 && m_slots == 0);
+				m_slots = ValueTraits::allocate(m_valueAllocator, capacity);
+				try {
+					m_control = ControlTraits::allocate(m_controlAllocator, capacity + 1);
+				} catch (...)
+				{
+					ValueTraits::deallocate(m_valueAllocator, m_slots, capacity);
+					m_slots = 0;
+					throw;
+				}
+				std::fill(m_control, m_control + capacity, EMPTY);
+				m_control[capacity] = SENTINEL;
+				m_capacity = capacity;
+			}
+
+
+			void deallocate()
+			{
+				if (m_capacity)
+				{
+					ValueTraits::deallocate(m_valueAllocator, m_slots, m_capacity);
+					ControlTraits::deallocate(m_controlAllocator, m_control, m_capacity + 1);
+					m_slots    = 0;
+					m_control  = emptyControl();
+					m_capacity = 0;
+				}
+			}
+
+
+			void destroyAll()
+			{
+				if (m_size == 0)
+				{
+					return;
+				}
+				for (size_type i = 0; i < m_capacity; ++i)
+				{
+					if (m_control[i] < EMPTY)
+					{
+						ValueTraits::destroy(m_valueAllocator, m_slots + i);
+					}
+				}
+			}
+
+
+			Value            *m_slots;
+			ControlType      *m_control;
+			size_type         m_capacity;
+			size_type         m_size;
+			size_type         m_deleted;
+			Hash              m_hash;
+			Equal             m_equal;
+			ValueAllocator    m_valueAllocator;
+			ControlAllocator  m_controlAllocator;
+	};
+}
+
+#endif
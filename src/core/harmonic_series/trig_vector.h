@@ -49,14 +49,16 @@
 namespace piranha
 {
 	/// Trigonometric vector.
-
-	template < typename T, int EchelonLevel >
-	class TrigVector: public VectorKey<T, EchelonLevel, TrigVector<T, EchelonLevel> >
+	/**
+	 * Up to InlineSize trigonometric multipliers are stored without memory allocation (see piranha::VectorKey).
+	 */
+	template < typename T, int EchelonLevel, std::size_t InlineSize = 0 >
+	class TrigVector: public VectorKey<T, EchelonLevel, TrigVector<T, EchelonLevel, InlineSize>, InlineSize>
 	{
 #ifdef DEBUG
         int TEchelonLevel = EchelonLevel;
 #endif
-			using Base =  VectorKey<T, EchelonLevel, TrigVector<T, EchelonLevel> >;
+			using Base =  VectorKey<T, EchelonLevel, TrigVector<T, EchelonLevel, InlineSize>, InlineSize>;
 
 			template <class SubSeries, class ArgsTuple>
 			class SubCache: public PowerCache<std::complex<SubSeries>, T, BaseSeriesArithmetics<std::complex<SubSeries>, ArgsTuple> >
@@ -177,7 +179,7 @@ namespace piranha
 			/// Copy ctor from different position.
             // IS that used anywhere ?? ExpoVector doesn't have it!!
 			template <int Position2>
-			TrigVector(const TrigVector<T, Position2> &trigVector): flavour(trigVector.getFlavour())
+			TrigVector(const TrigVector<T, Position2, InlineSize> &trigVector): flavour(trigVector.getFlavour())
 			{
 				this->resize(trigVector.size());
 				std::copy(trigVector.begin(), trigVector.end() ,this->begin());
@@ -883,13 +885,13 @@ namespace piranha
 
 
 	/// is_ring_exact type trait specialisation for TrigVector.
-	template <class T, int EchelonLevel>
-	struct is_ring_exact<TrigVector<T, EchelonLevel> >: boost::true_type {};
+	template <class T, int EchelonLevel, std::size_t InlineSize>
+	struct is_ring_exact<TrigVector<T, EchelonLevel, InlineSize> >: boost::true_type {};
 
 
 	/// is_trig_exact type trait specialisation for TrigVector.
-	template <class T, int EchelonLevel>
-	struct is_trig_exact<TrigVector<T, EchelonLevel> >: boost::true_type {};
+	template <class T, int EchelonLevel, std::size_t InlineSize>
+	struct is_trig_exact<TrigVector<T, EchelonLevel, InlineSize> >: boost::true_type {};
 }
 
 #endif
@@ -22,6 +22,9 @@
 #define PIRANHA_INTEGER_TYPEDEFS_H
 
 #include <boost/integer.hpp>
+#if !defined(__SIZEOF_INT128__)
+#include <boost/multiprecision/cpp_int.hpp>
+#endif
 
 #include "config.h"
 
@@ -31,6 +34,17 @@ namespace piranha
 	
 	// Assumed to be the smallest signed integer type as wide as a pointer.
 	using MaxFastInt = boost::int_t<sizeof(void*)* CHAR_BIT>::least;
+
+	// 128-bit signed integer, used for Kronecker codes whose range does not fit into MaxFastInt. The native type is used where the compiler
+	// provides one, otherwise fall back to the fixed-width integers of Boost.Multiprecision.
+#if defined(__SIZEOF_INT128__)
+	using MaxWideInt = __int128;
+#else
+	using MaxWideInt = boost::multiprecision::int128_t;
+#endif
+
+	// Number of value bits of MaxWideInt, excluding the sign.
+	constexpr int maxWideIntDigits = 127;
 }
 
 #endif
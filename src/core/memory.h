@@ -42,11 +42,11 @@ namespace piranha
 	// TODO: get rid of the T parameter, std_counting_allocator and friends.
 	/// STL-compatible allocator that decorates an existing allocator by adding a counting mechanism for the number of allocated bytes.
 	//
-	// The counting mechanism is thread-safe through the use of atomic operations. The counting is approximate though, in the sense that while concurrent
-	// allocations are taking place it is not guaranteed that at each moment the count read reflects exactly the number of allocated bytes.
-	// It may change between reaeding count and actual allocation, i.e. the underlying Allocator could still throw an exception.
-	// We could make it completely safe but for a performance penalty vs. a small risk of triggering the exception which could happen
-	// anyways as long as we using an non pre-allocated heap or memory pool.
+	// The counting goes through the per-thread balances of ThreadMemoryCounter, which are added to the shared atomic counter in batches,
+	// so that threads allocating concurrently do not contend for it. The counting is approximate, in the sense that the shared count
+	// misses up to ThreadMemoryCounter::batchSize bytes per thread, and the memory limit is checked only when a balance is added to it.
+	// The limit can hence be exceeded by that amount per thread. We could make it exact but for a performance penalty vs. a small risk,
+	// which is there anyway as long as we are using a non pre-allocated heap or memory pool.
 	//
 
 	template <typename T, typename Allocator = std::allocator<T> >
@@ -77,16 +77,19 @@ namespace piranha
 			[[nodiscard]] constexpr T* allocate(const size_type n)
 			{
 				// TODO: guard overflow here?
-				const std::size_t add      = n * sizeof(value_type);
-                std::size_t       current = counter;                  // current allocated memory size
-				std::size_t       memLimit = settings::get_memory_limit();
-				// Formulate in this way in order to avoid bogus values when doing memLimit - add
-				// (which is unsigned arithmetic).
-				if (add > memLimit || current > memLimit - add) // reqquest bigger than memory limit or would  exceeded it
-                {
-					PIRANHA_THROW(memory_error, "memory limit reached");
+				const std::size_t add = n * sizeof(value_type);
+				if (ThreadMemoryCounter::add(add))
+				{
+					// The balance of the thread is due to be added to the shared counter: check the memory limit on the total.
+					const std::size_t current  = ThreadMemoryCounter::total();          // including add
+					const std::size_t memLimit = settings::get_memory_limit();
+					if (add > memLimit || current > memLimit) // request bigger than memory limit or would exceed it
+					{
+						ThreadMemoryCounter::subtract(add);
+						PIRANHA_THROW(memory_error, "memory limit reached");
+					}
+					ThreadMemoryCounter::flush();
 				}
-				counter += add;   // this is atomic
 				T* retval = AllocInterface::allocate(m_alloc, n);
 
 				return retval;
@@ -94,16 +97,9 @@ namespace piranha
 
 			constexpr void deallocate(T* p, const size_type n)
 			{
-				std::size_t subtract = n * sizeof(value_type);
-
-
-				if (subtract > counter)
-				{
-					PIRANHA_THROW(memory_error, "memory underflow");
-				}
-				
+				// No underflow check: the balance of a thread freeing memory allocated by other threads is negative.
 				AllocInterface::deallocate(m_alloc, p, n);
-				counter -= subtract;  //this is atomic
+				ThreadMemoryCounter::subtract(n * sizeof(value_type));
 			}
 
 			bool operator==(const CountingAllocator& c) const
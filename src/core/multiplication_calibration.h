@@ -0,0 +1,216 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_MULTIPLICATION_CALIBRATION_H
+#define PIRANHA_MULTIPLICATION_CALIBRATION_H
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+
+#include "Psym.h"
+#include "fft.h"
+#include "settings.h"
+
+namespace piranha
+{
+	namespace detail
+	{
+		// Restore the algorithm and the number of threads at the end of the calibration.
+		class CalibrationGuard
+		{
+			public:
+
+				CalibrationGuard() : m_algorithm(settings::getMultiplicationAlgorithm()), m_nthread(settings::get_nthread()) {}
+
+				~CalibrationGuard()
+				{
+					settings::setMultiplicationAlgorithm(m_algorithm);
+					if (settings::get_nthread() != m_nthread)
+					{
+						settings::set_nthread(static_cast<unsigned>(m_nthread));
+					}
+				}
+
+			private:
+
+				const settings::MultiplicationAlgorithm	m_algorithm;
+				const std::size_t						m_nthread;
+		};
+
+
+		// Bivariate polynomial with n distinct unitary terms, exponents in [0, range[.
+		template <class Series>
+		Series calibrationSeries(const std::size_t n, const std::size_t range, const std::size_t seed)
+		{
+			const Series x(Psym("x")), y(Psym("y"));
+			Series retval;
+			for (std::size_t k = 0; k < n; ++k)
+			{
+				// 7919 is prime, hence coprime with range * range as long as range is not a multiple of it.
+				const std::size_t e = (7919 * k + seed) % (range * range);
+				retval += x.pow(static_cast<int>(e % range)) * y.pow(static_cast<int>(e / range));
+			}
+			return retval;
+		}
+
+
+		// Best of three timings of a * b, in microseconds. A quick calibration times a * b once.
+		template <class Series>
+		double calibrationTime(const Series &a, const Series &b, const settings::MultiplicationAlgorithm algorithm, const std::size_t nthread,
+		                       const bool quick)
+		{
+			settings::setMultiplicationAlgorithm(algorithm);
+			if (settings::get_nthread() != nthread)
+			{
+				settings::set_nthread(static_cast<unsigned>(nthread));
+			}
+			double retval = std::numeric_limits<double>::max();
+			for (int i = 0; i < (quick ? 1 : 3); ++i)
+			{
+				const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+				const Series c = a * b;
+				(void)c;
+				retval = std::min<double>(retval, static_cast<double>((boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds()));
+			}
+			return retval;
+		}
+
+
+		// Smallest size at which the threaded multiplication beats the single-threaded one.
+		template <class Series>
+		double calibrateThreading(const settings::MultiplicationAlgorithm algorithm, const std::size_t nthread, const double fallback, const bool quick)
+		{
+			// Force threading, whatever the size.
+			settings::MultiplicationThresholds always(settings::getMultiplicationThresholds());
+			always.threadedCoded = 0;
+			always.threadedPlain = 0;
+			for (std::size_t n = 8; n <= (quick ? 128u : 1024u); n *= 2)
+			{
+				const Series a = calibrationSeries<Series>(n, 1000, 0), b = calibrationSeries<Series>(n, 1000, 1);
+				const double single = calibrationTime(a, b, algorithm, 1, quick);
+				double threaded;
+				{
+					const settings::MultiplicationThresholdsOverride o(always);
+					threaded = calibrationTime(a, b, algorithm, nthread, quick);
+				}
+				if (threaded < single)
+				{
+					return static_cast<double>(n) * static_cast<double>(n);
+				}
+			}
+			return fallback;
+		}
+	}
+
+
+	/// Benchmark the multiplication kernels and tune the thresholds of the automatic algorithm selection.
+	/**
+	 * Series must be a polynomial manipulator (e.g., piranha::manipulators::dpoly). The measured thresholds become the
+	 * global ones and, if a file name is given, they are saved as a profile (see settings::saveMultiplicationProfile()).
+	 * The threading thresholds are measured only if more than one thread is available. A quick calibration
+	 * times each product once and stops at smaller operands, hence it is less accurate.
+	 */
+	template <class Series>
+	settings::MultiplicationThresholds calibrateMultiplication(const std::string &profile = std::string(), const bool quick = false)
+	{
+		typedef settings::MultiplicationAlgorithm Algorithm;
+
+		settings::MultiplicationThresholds retval(settings::getMultiplicationThresholds());
+		const std::size_t nthread = settings::get_nthread();
+		{
+			detail::CalibrationGuard guard;
+
+			// Plain versus coded: sparse operands of increasing length.
+			retval.plainCoded = 256. * 256.;
+			for (std::size_t n = 4; n <= (quick ? 64u : 256u); n *= 2)
+			{
+				const Series a = detail::calibrationSeries<Series>(n, 1000, 0), b = detail::calibrationSeries<Series>(n, 1000, 1);
+				if (detail::calibrationTime(a, b, Algorithm::HASH_CODED, 1, quick) < detail::calibrationTime(a, b, Algorithm::PLAIN, 1, quick))
+				{
+					retval.plainCoded = static_cast<double>(n) * static_cast<double>(n);
+					break;
+				}
+			}
+
+			// Vector versus hash coded: operands of fixed length and decreasing density. The width of the
+			// coded representation is capped, so that the dense array stays reasonably small.
+			const std::size_t n = 128;
+			double density = 1;
+			retval.sparseDensity = 0;
+			for (std::size_t range = 12; (2 * range - 1) * (2 * range - 1) <= (std::size_t(1) << (quick ? 16 : 22)); range *= 2)
+			{
+				const double previous = density;
+				density = static_cast<double>(n) / static_cast<double>((2 * range - 1) * (2 * range - 1));
+				const Series a = detail::calibrationSeries<Series>(n, range, 0), b = detail::calibrationSeries<Series>(n, range, 1);
+				if (detail::calibrationTime(a, b, Algorithm::HASH_CODED, 1, quick) < detail::calibrationTime(a, b, Algorithm::VECTOR_CODED, 1, quick))
+				{
+					retval.sparseDensity = std::min<double>(1, std::sqrt(previous * density));
+					break;
+				}
+			}
+			if (retval.sparseDensity == 0)
+			{
+				retval.sparseDensity = density;
+			}
+
+			// Direct versus FFT vector coded multiplication: dense operands of increasing length.
+			retval.fftCost = std::numeric_limits<double>::max();
+			for (std::size_t range = 4; range <= (quick ? 16u : 64u); range *= 2)
+			{
+				const Series a = detail::calibrationSeries<Series>(range * range, range, 0), b = detail::calibrationSeries<Series>(range * range, range, 1);
+				settings::MultiplicationThresholds fft(retval);
+				fft.fftCost = 0;
+				const double directTime = detail::calibrationTime(a, b, Algorithm::VECTOR_CODED, 1, quick);
+				double fftTime;
+				{
+					const settings::MultiplicationThresholdsOverride o(fft);
+					fftTime = detail::calibrationTime(a, b, Algorithm::FFT, 1, quick);
+				}
+				if (fftTime < directTime)
+				{
+					// Transform length for the codes of the calibration series, i.e., x^i * y^j -> i + j * (2 * range - 1).
+					const double n = static_cast<double>(FFT::length((range - 1) * 2 * range + 1, (range - 1) * 2 * range + 1));
+					retval.fftCost = static_cast<double>(range * range) * static_cast<double>(range * range) / (n * std::log2(n));
+					break;
+				}
+			}
+
+			if (nthread > 1)
+			{
+				retval.threadedPlain = detail::calibrateThreading<Series>(Algorithm::PLAIN, nthread, retval.threadedPlain, quick);
+				retval.threadedCoded = detail::calibrateThreading<Series>(Algorithm::HASH_CODED, nthread, retval.threadedCoded, quick);
+			}
+		}
+
+		settings::setMultiplicationThresholds(retval);
+		if (!profile.empty())
+		{
+			settings::saveMultiplicationProfile(profile);
+		}
+		return retval;
+	}
+}
+
+#endif
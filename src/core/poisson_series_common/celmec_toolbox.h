@@ -61,8 +61,7 @@ namespace piranha
 					Derived trig(M_series);
 					trig *= boost::numeric_cast<int>(i);
 					trig = trig.cos();
-					expansion_term *= trig;
-					tmp += expansion_term;
+					tmp.addmul(expansion_term, trig);
 				}
 				tmp *= e_series;
 				tmp *= -2;
@@ -77,9 +76,7 @@ namespace piranha
 				const int iter = e.psi(1);
 				for (int n = 1; n <= iter; ++n) 
                 {
-					Derived tmp = (M * n).cos();
-					tmp *= (e * n).besselJ(n);
-					retval += tmp;
+					retval.addmul((M * n).cos(), (e * n).besselJ(n));
 				}
 				retval *= 2;
 				retval += 1;
@@ -103,8 +100,7 @@ namespace piranha
 					Derived trig(M_series);
 					trig *= boost::numeric_cast<int>(i);
 					trig = trig.cos();
-					expansion_term *= trig;
-					tmp += expansion_term;
+					tmp.addmul(expansion_term, trig);
 				}
 
 				tmp *= -2;
@@ -126,8 +122,7 @@ namespace piranha
 					Derived trig(M_series);
 					trig *= boost::numeric_cast<int>(i);
 					trig = trig.sin();
-					expansion_term *= trig;
-					retval += expansion_term;
+					retval.addmul(expansion_term, trig);
 				}
 
 				retval *= 2;
@@ -154,8 +149,7 @@ namespace piranha
 					Derived trig(M_series);
 					trig *= boost::numeric_cast<int>(i);
 					trig = trig.sin();
-					expansion_term *= trig;
-					retval += expansion_term;
+					retval.addmul(expansion_term, trig);
 				}
 				retval *= tmp;
 				return retval;
@@ -181,8 +175,7 @@ namespace piranha
 					Derived trig(M_series);
 					trig *= boost::numeric_cast<int>(i);
 					trig = trig.cos();
-					expansion_term *= trig;
-					retval += expansion_term;
+					retval.addmul(expansion_term, trig);
 				}
 
 				retval *= tmp;
@@ -200,8 +193,7 @@ namespace piranha
                 {
 					Derived expansion_term((e_series * i).besselJ(i));
 					expansion_term /= boost::numeric_cast<int>(i);
-					expansion_term *= (M_series * boost::numeric_cast<int>(i)).sin();
-					tmp += expansion_term;
+					tmp.addmul(expansion_term, (M_series * boost::numeric_cast<int>(i)).sin());
 				}
 
 				tmp *= 2;
@@ -21,6 +21,7 @@
 #ifndef PIRANHA_POISSON_SERIES_MULTIPLIER_H
 #define PIRANHA_POISSON_SERIES_MULTIPLIER_H
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <utility> // For std::pair.
@@ -29,8 +30,10 @@
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/numeric/interval.hpp>
 #include <boost/tuple/tuple.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/type_traits/integral_constant.hpp>
 
+#include "../arena.h"
 #include "../base_classes/base_series_multiplier.h"
 #include "../base_classes/coded_multiplier.h"
 #include "../coded_hash_table.h"
@@ -40,6 +43,7 @@
 #include "../memory.h"
 #include "../settings.h" // For debug.
 #include "../stats.h"
+#include "../work_stealing_executor.h"
 
 namespace piranha
 {
@@ -191,12 +195,102 @@ namespace piranha
 					};
 
 
+					// Task for multi-threaded coded multiplication: both the plus and the minus products whose codes are in
+					// [lower, upper[ are accumulated. Tasks on disjoint ranges write into disjoint regions of the cosine and sine
+					// output structures.
+					template <class PlusFunctor, class MinusFunctor, class Code = MaxFastInt>
+					struct PlusMinusRangeTask {
+
+						PlusMinusRangeTask(PlusFunctor const &plus, MinusFunctor const &minus, BasicCodeRangeIndex<Code> const &index1,
+							               BasicCodeRangeIndex<Code> const &index2a, BasicCodeRangeIndex<Code> const &index2b,
+							               std::vector<std::size_t> const &rowEnds, Code const lower, Code const upper)
+                        : m_plus(plus), m_minus(minus), m_index1(index1), m_index2a(index2a), m_index2b(index2b), m_rowEnds(rowEnds),
+						  m_lower(lower), m_upper(upper) {}
+
+
+						void operator()()
+						{
+							codeRangeMultiplication(m_plus,  m_index1, m_index2a, m_rowEnds, m_lower, m_upper);
+							codeRangeMultiplication(m_minus, m_index1, m_index2b, m_rowEnds, m_lower, m_upper);
+						}
+
+						PlusFunctor						m_plus;
+						MinusFunctor					m_minus;
+						BasicCodeRangeIndex<Code> const	&m_index1;
+						BasicCodeRangeIndex<Code> const	&m_index2a;
+						BasicCodeRangeIndex<Code> const	&m_index2b;
+						std::vector<std::size_t> const	&m_rowEnds;
+						const Code						m_lower;
+						const Code						m_upper;
+					};
+
+
+					// Half of the work of VectorFunctor, used in multi-threaded vector coded multiplication: only the
+					// product codes given by either the plus (ck2a) or the minus (ck2b) Werner formula are written.
+					template <bool Plus, class GenericTruncator>
+					struct VectorHalfFunctor {
+
+						VectorHalfFunctor(std::vector<char>               &f1,         std::vector<char>         &f2,
+							              std::vector<CfType1>            &tc1,        std::vector<CfType2>      &tc2,
+							              std::vector<MaxFastInt>         &ck1,        std::vector<MaxFastInt>   &ck2,
+							              std::vector<const TermType1 *>  &t1,         std::vector<const TermType2 *> &t2,
+							              const GenericTruncator          &truncator,  std::pair<CfType1 *, CfType1 *> *vc_res_pair, const ArgsTuple &argsTuple)
+                        : m_f1(f1), m_f2(f2), m_tc1(tc1), m_tc2(tc2), m_ck1(ck1), m_ck2(ck2), m_t1(t1), m_t2(t2), truncator(truncator),
+						  m_vc_res_pair(vc_res_pair), m_argsTuple(argsTuple) {}
+
+
+						bool operator()(std::size_t const i, std::size_t const j)
+						{
+							if (truncator.skip(&m_t1[i], &m_t2[j]))
+							{
+								return false;
+							}
+
+							const MaxFastInt index = m_ck1[i] + m_ck2[j];
+							// Fix flavour and coefficient sign, as in VectorFunctor.
+							CfType1 *vc_res;
+							bool negative;
+							if (m_f1[i] == m_f2[j])
+							{
+								vc_res   = m_vc_res_pair->first;
+								negative = Plus && !m_f1[i];
+							} else
+							{
+								vc_res   = m_vc_res_pair->second;
+								negative = !Plus && m_f1[i];
+							}
+
+							if (negative)
+							{
+								CfType1 tmp_cf = m_tc1[i];
+								tmp_cf.multBy(m_tc2[j], m_argsTuple);
+								vc_res[index].subtract(tmp_cf, m_argsTuple);
+							} else
+							{
+								vc_res[index].addmul(m_tc1[i], m_tc2[j], m_argsTuple);
+							}
+							return true;
+						}
+
+						std::vector<char>					&m_f1;
+						std::vector<char>					&m_f2;
+						std::vector<CfType1>				&m_tc1;
+						std::vector<CfType2>				&m_tc2;
+						std::vector<MaxFastInt>				&m_ck1;
+						std::vector<MaxFastInt>				&m_ck2;
+						std::vector<const TermType1 *>		&m_t1;
+						std::vector<const TermType2 *>		&m_t2;
+						const GenericTruncator				&truncator;
+						std::pair<CfType1 *, CfType1 *>	   *m_vc_res_pair;
+						const ArgsTuple						&m_argsTuple;
+					};
+
+
 					template <class GenericTruncator>
 					bool performVectorCodedMultiplication(std::vector<CfType1>           &tc1, std::vector<CfType2>           &tc2, 
                                                           std::vector<const TermType1 *> &t1,  std::vector<const TermType2 *> &t2,
                                                           const GenericTruncator &truncator)
 					{
-						stats::trace_stat("mult_st: vector-poisson", std::size_t(0), increment);
 						std::vector<CfType1, CountingAllocator<CfType1>  > vc_cos;
                         std::vector<CfType1, CountingAllocator<CfType1>  > vc_sin;
 						// Try to allocate the space for vector coded multiplication. We need two arrays of results,
@@ -230,62 +324,134 @@ namespace piranha
 						const ArgsTupleType &argsTuple = this->argsTuple;
 						std::pair<CfType1 *, CfType1 *> res(&vc_cos[0] - this->m_fast_h.lower(), &vc_sin[0] - this->m_fast_h.lower());
 						
-                        // Find out a suitable block size.
-						std::size_t const blockSize = this->template computeBlockSize<sizeof(CfType1)>();
-						
-                        PIRANHA_DEBUG(std::cout << "Block size: " << blockSize << '\n';)
+						const std::size_t nthread = std::min(settings::get_nthread(), std::min(size1, size2));
+
+						// When squaring, the products of (i, j) and (j, i) differ only in the sign of the multipliers of the minus
+						// codes, which canonicalisation removes when decoding: the pairs with j < i are folded onto the others.
+						const bool squaring = this->isSquaring();
+						std::vector<CfType2> tc2Doubled;
+						if (squaring)
+						{
+							stats::trace_stat("mult_square", std::size_t(0), increment);
+							tc2Doubled = this->doubledCoefficients(tc2);
+						}
+
+						// The pairs cut by the truncator are never visited, hence only the others count towards threading.
+						const std::vector<std::size_t> rowEnds = this->computeRowEnds(t1, t2, truncator);
+						if (this->countPairs(rowEnds) <= settings::getMultiplicationThresholds().threadedCoded || nthread == 1)
+						{
+							stats::trace_stat("mult_st: vector-poisson", std::size_t(0), increment);
+							// Find out suitable block sizes.
+							typename Ancestor::BlockSizes const blockSizes = this->template computeBlockSizes<sizeof(CfType1)>();
+
+							PIRANHA_DEBUG(std::cout << "Block sizes: " << blockSizes[0] << ',' << blockSizes[1] << ',' << blockSizes[2] << '\n';)
+
+							// Perform multiplication.
+							typedef VectorFunctor<GenericTruncator> VectorFunctorType;
+							CodedSquaringFunctor<VectorFunctorType>
+								vm(VectorFunctorType(flavours1, flavours2, tc1, tc2, this->m_ckeys1, this->m_ckeys2a, this->m_ckeys2b, t1, t2, truncator, &res, argsTuple),
+								   VectorFunctorType(flavours1, flavours2, tc1, tc2Doubled, this->m_ckeys1, this->m_ckeys2a, this->m_ckeys2b, t1, t2, truncator, &res, argsTuple),
+								   squaring);
+							if (squaring)
+							{
+								this->blockedSquaring(blockSizes, rowEnds, vm);
+							} else
+							{
+								this->blockedMultiplication(blockSizes, rowEnds, vm);
+							}
+						} else
+						{
+							// Each task handles a disjoint range of the output codes, hence disjoint regions of vc_cos and vc_sin.
+							PIRANHA_DEBUG(std::cout << "using " << nthread << " threads\n");
+							stats::trace_stat("mult_mt: vector-poisson", std::size_t(0), increment);
+
+							typedef VectorHalfFunctor<true,  GenericTruncator> PlusHalfFunctor;
+							typedef VectorHalfFunctor<false, GenericTruncator> MinusHalfFunctor;
+							typedef CodedSquaringFunctor<PlusHalfFunctor>      PlusFunctor;
+							typedef CodedSquaringFunctor<MinusHalfFunctor>     MinusFunctor;
+
+							const CodeRangeIndex index1(this->m_ckeys1);
+							const CodeRangeIndex index2a(this->m_ckeys2a);
+							const CodeRangeIndex index2b(this->m_ckeys2b);
+							const std::vector<MaxFastInt> splits = computeCodeSplits(this->m_ckeys1, codeIndices(index2a, index2b), this->template vectorCodedTasks<2 * sizeof(CfType1)>(nthread));
+
+							const PlusFunctor  plus (PlusHalfFunctor (flavours1, flavours2, tc1, tc2, this->m_ckeys1, this->m_ckeys2a, t1, t2, truncator, &res, argsTuple),
+							                         PlusHalfFunctor (flavours1, flavours2, tc1, tc2Doubled, this->m_ckeys1, this->m_ckeys2a, t1, t2, truncator, &res, argsTuple),
+							                         squaring);
+							const MinusFunctor minus(MinusHalfFunctor(flavours1, flavours2, tc1, tc2, this->m_ckeys1, this->m_ckeys2b, t1, t2, truncator, &res, argsTuple),
+							                         MinusHalfFunctor(flavours1, flavours2, tc1, tc2Doubled, this->m_ckeys1, this->m_ckeys2b, t1, t2, truncator, &res, argsTuple),
+							                         squaring);
+							std::vector<PlusMinusRangeTask<PlusFunctor, MinusFunctor> > tasks;
+							tasks.reserve(splits.size() - 1);
+							for (std::size_t i = 0; i < splits.size() - 1; ++i)
+							{
+								tasks.push_back(PlusMinusRangeTask<PlusFunctor, MinusFunctor>(plus, minus, index1, index2a, index2b, rowEnds, splits[i], splits[i + 1]));
+							}
 
-						// Perform multiplication.
-						VectorFunctor<GenericTruncator> vm(flavours1, flavours2, tc1, tc2, this->m_ckeys1, this->m_ckeys2a, this->m_ckeys2b, t1, t2, truncator, &res, argsTuple);
-						this->blockedMultiplication(blockSize, size1, size2, vm);
+							WorkStealingExecutor executor(nthread);
+							executor.run(tasks);
+							executor.traceStats("mult_mt:");
+						}
 
 						PIRANHA_DEBUG(std::cout << "Done multiplying\n");
 
 						// Decode and insert the results into return value.
-						CfType1 *vc_res_cos = res.first;
-						CfType1 *vc_res_sin = res.second;
-						TermType1 tmp_term;
-						const MaxFastInt i_f = this->m_fast_h.upper();
+						const VectorDecoder decoder(*this, res, argsTuple);
+						this->vectorDecodeAndInsert(decoder, settings::get_nthread());
+
+						PIRANHA_DEBUG(std::cout << "Done Poisson series vector coded\n");
+						return true;
+					}
+
+
+					// Decode the cosine and sine results of vector coded multiplication.
+					struct VectorDecoder
+					{
+						// Canonicalisation may map two codes onto the same term (e.g., cos(x-y) and cos(y-x)).
+						static const bool uniqueTerms = false;
 
-						for (MaxFastInt i = this->m_fast_h.lower(); i <= i_f; ++i)
+						VectorDecoder(get_type const &multiplier, std::pair<CfType1 *, CfType1 *> const &vc_res_pair, const ArgsTuple &argsTuple)
+                            : m_multiplier(multiplier), m_vc_res_pair(vc_res_pair), m_argsTuple(argsTuple)
+						{}
+
+
+						template <class Out>
+						void operator()(MaxFastInt const lower, MaxFastInt const upper, Out &out) const
 						{
-							vc_res_cos[i].divideBy(2, argsTuple);
-							// Take a shortcut and check for ignorability of the coefficient here.
-							// This way we avoid decodification, and all the series term insertion yadda-yadda.
-							if (!vc_res_cos[i].isIgnorable(argsTuple)) 
-							{
-								this->decode(vc_res_cos[i], i, tmp_term);
-								tmp_term.key.setFlavour(true);
-								// Canonicalise in-place, so that we don't need to make further copies in the
-								// main insertion function.
-								if (!tmp_term.isCanonical(argsTuple)) 
-								{
-									tmp_term.canonicalise(argsTuple);
-								}
-								this->retval.insert(tmp_term, argsTuple);
-							}
+							decode<true>(m_vc_res_pair.first, lower, upper, out);
+							decode<false>(m_vc_res_pair.second, lower, upper, out);
 						}
 
-						for (MaxFastInt i = this->m_fast_h.lower(); i <= i_f; ++i) 
-						{
-							vc_res_sin[i].divideBy(2, argsTuple);
 
-							if (!vc_res_sin[i].isIgnorable(argsTuple)) 
+						template <bool Flavour, class Out>
+						void decode(CfType1 *vc_res, MaxFastInt const lower, MaxFastInt const upper, Out &out) const
+						{
+							TermType1 tmp_term;
+							for (MaxFastInt i = lower; i < upper; ++i)
 							{
-								this->decode(vc_res_sin[i], i, tmp_term);
-								tmp_term.key.setFlavour(false);
-
-								if (!tmp_term.isCanonical(argsTuple)) 
+								vc_res[i].divideBy(2, m_argsTuple);
+								// Take a shortcut and check for ignorability of the coefficient here.
+								// This way we avoid decodification, and all the series term insertion yadda-yadda.
+								if (!vc_res[i].isIgnorable(m_argsTuple))
 								{
-									tmp_term.canonicalise(argsTuple);
+									m_multiplier.decode(vc_res[i], i, tmp_term);
+									tmp_term.key.setFlavour(Flavour);
+									// Canonicalise in-place, so that we don't need to make further copies in the
+									// main insertion function.
+									if (!tmp_term.isCanonical(m_argsTuple))
+									{
+										tmp_term.canonicalise(m_argsTuple);
+									}
+									out.push_back(tmp_term);
 								}
-								this->retval.insert(tmp_term, argsTuple);
 							}
 						}
 
-						PIRANHA_DEBUG(std::cout << "Done Poisson series vector coded\n");
-						return true;
-					}
+
+						get_type const							&m_multiplier;
+						const std::pair<CfType1 *, CfType1 *>	m_vc_res_pair;
+						const ArgsTuple							&m_argsTuple;
+					};
 
 
 					template <class Cterm, class Ckey, class GenericTruncator, class HashSet>
@@ -407,71 +573,356 @@ namespace piranha
 					};
 
 
-					template <class GenericTruncator>
+					// Half of the work of HashFunctor, used in multi-threaded hash coded multiplication: only the
+					// product codes given by either the plus (ck2a) or the minus (ck2b) Werner formula are inserted.
+					template <bool Plus, class Cterm, class Ckey, class GenericTruncator, class HashSet>
+					struct HashHalfFunctor {
+
+						HashHalfFunctor(std::vector<char>              &f1,        std::vector<char>    &f2,
+							            std::vector<CfType1>           &tc1,       std::vector<CfType2> &tc2,
+							            std::vector<Ckey>              &ck1,       std::vector<Ckey>    &ck2,
+							            std::vector<const TermType1 *> &t1,        std::vector<const TermType2 *> &t2,
+							            const GenericTruncator         &truncator, HashSet *cms_cos, HashSet *cms_sin, Cterm *tmp_term,
+							            const ArgsTuple &argsTuple)
+                        : m_f1(f1), m_f2(f2), m_tc1(tc1), m_tc2(tc2), m_ck1(ck1), m_ck2(ck2), m_t1(t1), m_t2(t2),
+							truncator(truncator), m_cms_cos(cms_cos), m_cms_sin(cms_sin), m_tmp_term(tmp_term), m_argsTuple(argsTuple) {}
+
+
+						bool operator()(const std::size_t i, const std::size_t j)
+						{
+							typedef typename HashSet::iterator c_iterator;
+
+							if (truncator.skip(&m_t1[i], &m_t2[j]))
+							{
+								return false;
+							}
+
+							Cterm &tmp_term = *m_tmp_term;
+							tmp_term.first  = m_tc1[i];
+							tmp_term.first.multBy(m_tc2[j], m_argsTuple);
+							tmp_term.second = m_ck1[i] + m_ck2[j];
+
+							PIRANHA_ASSERT(tmp_term.second >= 0);
+
+							// Fix flavour and coefficient sign, as in HashFunctor.
+							HashSet *cms;
+							if (m_f1[i] == m_f2[j]) 
+							{
+								cms = m_cms_cos;
+								if (Plus && !m_f1[i]) 
+								{
+									tmp_term.first.invertSign(m_argsTuple);
+								}
+							} else 
+							{
+								cms = m_cms_sin;
+								if (!Plus && m_f1[i]) 
+								{
+									tmp_term.first.invertSign(m_argsTuple);
+								}
+							}
+
+							std::pair<bool, c_iterator> res = cms->find(tmp_term.second);
+							if (res.first) 
+							{
+								res.second->first.add(tmp_term.first, m_argsTuple);
+							} else 
+							{
+								cms->insert_new(tmp_term, res.second);
+							}
+
+							return true;
+						}
+
+						std::vector<char>				&m_f1;
+						std::vector<char>				&m_f2;
+						std::vector<CfType1>			&m_tc1;
+						std::vector<CfType2>			&m_tc2;
+						std::vector<Ckey>				&m_ck1;
+						std::vector<Ckey>				&m_ck2;
+						std::vector<const TermType1 *>	&m_t1;
+						std::vector<const TermType2 *>	&m_t2;
+						const GenericTruncator			&truncator;
+						HashSet							*m_cms_cos;
+						HashSet							*m_cms_sin;
+						Cterm							*m_tmp_term;
+						const ArgsTuple					&m_argsTuple;
+					};
+
+
+					// Hash coded multiplication, with codes of type Code (MaxFastInt, or MaxWideInt for the wide coding tier).
+					template <class Code, class GenericTruncator>
 					void performHashCodedMultiplication(std::vector<CfType1>           &tc1, std::vector<CfType2> &tc2, 
                                                         std::vector<const TermType1 *> &t1,  std::vector<const TermType2 *> &t2,
                                                         GenericTruncator const &truncator)
 					{
-						stats::trace_stat("mult_st: hash-poisson", std::size_t(0), increment);
-
-						typedef coded_hash_table<CfType1, MaxFastInt, CountingAllocator<char> > csht;
-						typedef typename csht::iterator c_iterator;
+						typedef coded_hash_table<CfType1, Code, ArenaAllocator<char> > csht;
+						typedef std::pair<CfType1, Code> Cterm;
 						// Let's find a sensible size hint.
-						const std::size_t n_codes = boost::numeric_cast<std::size_t>(boost::numeric::width(this->m_fast_h) + 1);
-						const std::size_t size_hint = static_cast<std::size_t>(std::max<double>(this->m_density1,this->m_density2) * n_codes);
+						const std::size_t size_hint = this->hashSizeHint();
+						std::vector<Code> &ck1  = this->template codes1<Code>();
+						std::vector<Code> &ck2a = this->template codes2a<Code>();
+						std::vector<Code> &ck2b = this->template codes2b<Code>();
 
-						csht cms_cos(size_hint); 
-						csht cms_sin(size_hint);
-						std::pair<csht *, csht *> res(&cms_cos, &cms_sin);
 						const std::size_t size1 = this->terms1.size();
 						const std::size_t size2 = this->terms2.size();
 						const ArgsTupleType &argsTuple = this->argsTuple;
+						const std::size_t nthread = std::min(settings::get_nthread(), std::min(size1, size2));
 
-						// Find out a suitable block size.
-						const std::size_t blockSize = this->template computeBlockSize<sizeof(std::pair<CfType1, MaxFastInt>)>();
-						PIRANHA_DEBUG(std::cout << "Block size: " << blockSize << '\n';)
-						std::pair<CfType1, MaxFastInt> tmp_term1;
-                        std::pair<CfType1, MaxFastInt> tmp_term2;
-						HashFunctor<std::pair<CfType1, MaxFastInt>, MaxFastInt, GenericTruncator, csht>
-							hm(flavours1, flavours2, tc1, tc2, this->m_ckeys1, this->m_ckeys2a, this->m_ckeys2b, t1, t2, truncator, &res, &tmp_term1, &tmp_term2, argsTuple);
+						// Pairs folded as in vector coded squaring.
+						const bool squaring = this->isSquaring();
+						std::vector<CfType2> tc2Doubled;
+						if (squaring)
+						{
+							stats::trace_stat("mult_square", std::size_t(0), increment);
+							tc2Doubled = this->doubledCoefficients(tc2);
+						}
 
-						this->blockedMultiplication(blockSize, size1, size2, hm);
+						// The hash tables, and the tables they are resized from, are all given back at the end of the multiplication.
+						Arena arena(this->template hashArenaChunkSize<sizeof(Cterm)>());
+						const ArenaAllocator<char> allocator(arena);
 
-						PIRANHA_DEBUG(std::cout << "Done Poisson series hash coded multiplying\n");
+						// The pairs cut by the truncator are never visited, hence only the others count towards threading.
+						const std::vector<std::size_t> rowEnds = this->computeRowEnds(t1, t2, truncator);
+						if (this->countPairs(rowEnds) <= settings::getMultiplicationThresholds().threadedCoded || nthread == 1)
+						{
+							stats::trace_stat("mult_st: hash-poisson", std::size_t(0), increment);
+
+							csht cms_cos(size_hint, allocator);
+							csht cms_sin(size_hint, allocator);
+							std::pair<csht *, csht *> res(&cms_cos, &cms_sin);
+
+							// Find out suitable block sizes.
+							const typename Ancestor::BlockSizes blockSizes = this->template computeBlockSizes<sizeof(Cterm)>();
+							PIRANHA_DEBUG(std::cout << "Block sizes: " << blockSizes[0] << ',' << blockSizes[1] << ',' << blockSizes[2] << '\n';)
+							Cterm tmp_term1;
+							Cterm tmp_term2;
+							typedef HashFunctor<Cterm, Code, GenericTruncator, csht> HashFunctorType;
+							CodedSquaringFunctor<HashFunctorType>
+								hm(HashFunctorType(flavours1, flavours2, tc1, tc2, ck1, ck2a, ck2b, t1, t2, truncator, &res, &tmp_term1, &tmp_term2, argsTuple),
+								   HashFunctorType(flavours1, flavours2, tc1, tc2Doubled, ck1, ck2a, ck2b, t1, t2, truncator, &res, &tmp_term1, &tmp_term2, argsTuple),
+								   squaring);
+
+							if (squaring)
+							{
+								this->blockedSquaring(blockSizes, rowEnds, hm);
+							} else
+							{
+								this->blockedMultiplication(blockSizes, rowEnds, hm);
+							}
 
-						TermType1 tmp_term;
+							PIRANHA_DEBUG(std::cout << "Done Poisson series hash coded multiplying\n");
+
+							this->reserveResult(cms_cos.size() + cms_sin.size());
+							insertHashCodedResults(cms_cos, true);
+							insertHashCodedResults(cms_sin, false);
+						} else
 						{
-							const c_iterator c_it_f = cms_cos.end();
-							for (c_iterator c_it = cms_cos.begin(); c_it != c_it_f; ++c_it) 
+							// Each pair of terms produces a plus and a minus code, possibly falling into different
+							// ranges of the output code space. Each task owns a range and inserts both kinds of products
+							// falling into it, so that the cosine and sine tables of different tasks never share a code.
+							PIRANHA_DEBUG(std::cout << "using " << nthread << " threads\n");
+							stats::trace_stat("mult_mt: hash-poisson", std::size_t(0), increment);
+
+							typedef HashHalfFunctor<true,  Cterm, Code, GenericTruncator, csht> PlusHalfFunctor;
+							typedef HashHalfFunctor<false, Cterm, Code, GenericTruncator, csht> MinusHalfFunctor;
+							typedef CodedSquaringFunctor<PlusHalfFunctor>                       PlusFunctor;
+							typedef CodedSquaringFunctor<MinusHalfFunctor>                      MinusFunctor;
+
+							const BasicCodeRangeIndex<Code> index1(ck1);
+							const BasicCodeRangeIndex<Code> index2a(ck2a);
+							const BasicCodeRangeIndex<Code> index2b(ck2b);
+							const std::vector<Code> splits = computeCodeSplits(ck1, codeIndices(index2a, index2b), nthread * CodedAncestor::tasksPerThread);
+							const std::size_t n = splits.size() - 1;
+
+							std::vector<csht> tables_cos(n, csht(size_hint / n, allocator));
+							std::vector<csht> tables_sin(n, csht(size_hint / n, allocator));
+							std::vector<Cterm> tmp_terms(n);
+							std::vector<PlusMinusRangeTask<PlusFunctor, MinusFunctor, Code> > tasks;
+							tasks.reserve(n);
+							for (std::size_t i = 0; i < n; ++i)
 							{
-								(c_it->first).divideBy(2, argsTuple);
-								this->decode(c_it->first, c_it->second + 2 * this->m_fast_h.lower(), tmp_term);
-								tmp_term.key.setFlavour(true);
-								if (!tmp_term.isCanonical(argsTuple)) 
-								{
-									tmp_term.canonicalise(argsTuple);
-								}
-								this->retval.insert(tmp_term, argsTuple);
+								tasks.push_back(PlusMinusRangeTask<PlusFunctor, MinusFunctor, Code>(
+									PlusFunctor (PlusHalfFunctor (flavours1, flavours2, tc1, tc2, ck1, ck2a, t1, t2, truncator, &tables_cos[i], &tables_sin[i], &tmp_terms[i], argsTuple),
+									             PlusHalfFunctor (flavours1, flavours2, tc1, tc2Doubled, ck1, ck2a, t1, t2, truncator, &tables_cos[i], &tables_sin[i], &tmp_terms[i], argsTuple),
+									             squaring),
+									MinusFunctor(MinusHalfFunctor(flavours1, flavours2, tc1, tc2, ck1, ck2b, t1, t2, truncator, &tables_cos[i], &tables_sin[i], &tmp_terms[i], argsTuple),
+									             MinusHalfFunctor(flavours1, flavours2, tc1, tc2Doubled, ck1, ck2b, t1, t2, truncator, &tables_cos[i], &tables_sin[i], &tmp_terms[i], argsTuple),
+									             squaring),
+									index1, index2a, index2b, rowEnds, splits[i], splits[i + 1]));
+							}
+
+							WorkStealingExecutor executor(nthread);
+							executor.run(tasks);
+							executor.traceStats("mult_mt:");
+
+							PIRANHA_DEBUG(std::cout << "Done Poisson series hash coded multiplying\n");
+
+							std::size_t nterms = 0;
+							for (std::size_t i = 0; i < n; ++i)
+							{
+								nterms += tables_cos[i].size() + tables_sin[i].size();
+							}
+							this->reserveResult(nterms);
+
+							for (std::size_t i = 0; i < n; ++i)
+							{
+								insertHashCodedResults(tables_cos[i], true);
+								insertHashCodedResults(tables_sin[i], false);
 							}
 						}
+
+						PIRANHA_DEBUG(std::cout << "Done Poisson series hash coded\n");
+					}
+
+
+					// Split coded multiplication: the terms are grouped by their outer codes, and each pair of groups
+					// is multiplied through hash coded multiplication of the inner codes. Plus and minus products
+					// end up in the cosine and sine tables of different outer codes.
+					template <class GenericTruncator>
+					void performSplitCodedMultiplication(std::vector<CfType1>           &tc1, std::vector<CfType2> &tc2, 
+                                                         std::vector<const TermType1 *> &t1,  std::vector<const TermType2 *> &t2,
+                                                         GenericTruncator const &truncator)
+					{
+						typedef coded_hash_table<CfType1, MaxFastInt, ArenaAllocator<char> > csht;
+						typedef std::pair<CfType1, MaxFastInt> Cterm;
+						typedef HashHalfFunctor<true,  Cterm, MaxFastInt, GenericTruncator, csht> PlusFunctor;
+						typedef HashHalfFunctor<false, Cterm, MaxFastInt, GenericTruncator, csht> MinusFunctor;
+						typedef typename CodedAncestor::SplitBucket SplitBucket;
+						typedef boost::unordered_map<std::vector<MaxFastInt>, std::pair<csht, csht> > TableMap;
+
+						stats::trace_stat("mult_st: split-poisson", std::size_t(0), increment);
+
+						const ArgsTupleType &argsTuple = this->argsTuple;
+						const std::vector<SplitBucket> buckets1  = CodedAncestor::splitBuckets(this->m_split_ckeys1);
+						const std::vector<SplitBucket> buckets2a = CodedAncestor::splitBuckets(this->m_split_ckeys2a);
+						const std::vector<SplitBucket> buckets2b = CodedAncestor::splitBuckets(this->m_split_ckeys2b);
+
+						Arena arena(this->template hashArenaChunkSize<sizeof(Cterm)>());
+						const ArenaAllocator<char> allocator(arena);
+						TableMap tables;
+						// Cosine and sine tables of an outer code, created on first use.
+						auto tablesOf = [&tables, &allocator](std::vector<MaxFastInt> const &outer) -> std::pair<csht, csht> &
 						{
-							const c_iterator c_it_f = cms_sin.end();
-							for (c_iterator c_it = cms_sin.begin(); c_it != c_it_f; ++c_it) 
+							typename TableMap::iterator it = tables.find(outer);
+							if (it == tables.end())
 							{
-								c_it->first.divideBy(2,argsTuple);
-								this->decode(c_it->first,c_it->second + 2 * this->m_fast_h.lower(),tmp_term);
-								tmp_term.key.setFlavour(false);
-								if (!tmp_term.isCanonical(argsTuple)) 
-								{
-									tmp_term.canonicalise(argsTuple);
-								}
-								this->retval.insert(tmp_term, argsTuple);
+								it = tables.insert(std::make_pair(outer, std::make_pair(csht(allocator), csht(allocator)))).first;
+							}
+							return it->second;
+						};
+						std::vector<MaxFastInt> outer;
+						Cterm tmp_term;
+						for (std::size_t b1 = 0; b1 < buckets1.size(); ++b1)
+						{
+							for (std::size_t b2 = 0; b2 < buckets2a.size(); ++b2)
+							{
+								CodedAncestor::splitOuterSum(buckets1[b1].outer, buckets2a[b2].outer, outer);
+								std::pair<csht, csht> &res = tablesOf(outer);
+								PlusFunctor plus(flavours1, flavours2, tc1, tc2, this->m_split_ckeys1[0], this->m_split_ckeys2a[0], t1, t2, truncator,
+								                 &res.first, &res.second, &tmp_term, argsTuple);
+								splitBucketsMultiplication(plus, buckets1[b1], buckets2a[b2]);
+							}
+							for (std::size_t b2 = 0; b2 < buckets2b.size(); ++b2)
+							{
+								CodedAncestor::splitOuterSum(buckets1[b1].outer, buckets2b[b2].outer, outer);
+								std::pair<csht, csht> &res = tablesOf(outer);
+								MinusFunctor minus(flavours1, flavours2, tc1, tc2, this->m_split_ckeys1[0], this->m_split_ckeys2b[0], t1, t2, truncator,
+								                   &res.first, &res.second, &tmp_term, argsTuple);
+								splitBucketsMultiplication(minus, buckets1[b1], buckets2b[b2]);
 							}
 						}
-						PIRANHA_DEBUG(std::cout << "Done Poisson series hash coded\n");
+
+						PIRANHA_DEBUG(std::cout << "Done Poisson series split coded multiplying\n");
+
+						std::size_t nterms = 0;
+						for (typename TableMap::iterator it = tables.begin(); it != tables.end(); ++it)
+						{
+							nterms += it->second.first.size() + it->second.second.size();
+						}
+						this->reserveResult(nterms);
+
+						for (typename TableMap::iterator it = tables.begin(); it != tables.end(); ++it)
+						{
+							insertSplitCodedResults(it->first, it->second.first, true);
+							insertSplitCodedResults(it->first, it->second.second, false);
+						}
 					}
 
 				private:
+					// Multiply all the pairs of terms of two buckets of split coded multiplication.
+					template <class Functor, class SplitBucket>
+					static void splitBucketsMultiplication(Functor &functor, const SplitBucket &bucket1, const SplitBucket &bucket2)
+					{
+						for (std::size_t i = 0; i < bucket1.terms.size(); ++i)
+						{
+							for (std::size_t j = 0; j < bucket2.terms.size(); ++j)
+							{
+								functor(bucket1.terms[i], bucket2.terms[j]);
+							}
+						}
+					}
+
+
+					// Same as insertHashCodedResults(), for the cosine or sine table of the outer codes of split coded multiplication.
+					template <class CodedHashTable>
+					void insertSplitCodedResults(const std::vector<MaxFastInt> &outer, CodedHashTable &cms, const bool flavour)
+					{
+						typedef typename CodedHashTable::iterator c_iterator;
+
+						const ArgsTupleType &argsTuple = this->argsTuple;
+						const c_iterator c_it_f = cms.end();
+						TermType1 tmp_term;
+
+						for (c_iterator c_it = cms.begin(); c_it != c_it_f; ++c_it) 
+						{
+							c_it->first.divideBy(2, argsTuple);
+							this->decodeSplit(c_it->first, c_it->second, outer, tmp_term);
+							tmp_term.key.setFlavour(flavour);
+							if (!tmp_term.isCanonical(argsTuple)) 
+							{
+								tmp_term.canonicalise(argsTuple);
+							}
+							this->retval.insert(tmp_term, argsTuple);
+						}
+					}
+
+
+					// The plus and minus code indices of the second series, for piranha::computeCodeSplits.
+					template <class Code>
+					static std::vector<BasicCodeRangeIndex<Code> const *> codeIndices(BasicCodeRangeIndex<Code> const &index2a, BasicCodeRangeIndex<Code> const &index2b)
+					{
+						std::vector<BasicCodeRangeIndex<Code> const *> retval;
+						retval.push_back(&index2a);
+						retval.push_back(&index2b);
+						return retval;
+					}
+
+
+					// Decode the content of a cosine or sine coded hash table and insert it into retval.
+					template <class CodedHashTable>
+					void insertHashCodedResults(CodedHashTable &cms, const bool flavour)
+					{
+						typedef typename CodedHashTable::iterator c_iterator;
+						typedef typename CodedHashTable::KeyType Code;
+
+						const ArgsTupleType &argsTuple = this->argsTuple;
+						const c_iterator c_it_f = cms.end();
+						TermType1 tmp_term;
+
+						for (c_iterator c_it = cms.begin(); c_it != c_it_f; ++c_it) 
+						{
+							c_it->first.divideBy(2, argsTuple);
+							this->decode(c_it->first, static_cast<Code>(c_it->second + 2 * this->template minCode<Code>()), tmp_term);
+							tmp_term.key.setFlavour(flavour);
+							if (!tmp_term.isCanonical(argsTuple)) 
+							{
+								tmp_term.canonicalise(argsTuple);
+							}
+							this->retval.insert(tmp_term, argsTuple);
+						}
+					}
+
 					// For Poisson series we also need flavours.
 					std::vector<char>	flavours1;
 					std::vector<char>	flavours2;
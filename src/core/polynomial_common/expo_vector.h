@@ -43,18 +43,21 @@
 #include "../type_traits.h"
 #include "expo_vector_mp.h"
 
-#define PIRANHA_EXPO_VECTOR_TP_DECL class T, int EchelonLevel
-#define PIRANHA_EXPO_VECTOR_TP T, EchelonLevel
+#define PIRANHA_EXPO_VECTOR_TP_DECL class T, int EchelonLevel, std::size_t InlineSize
+#define PIRANHA_EXPO_VECTOR_TP T, EchelonLevel, InlineSize
 
 namespace piranha
 {
 	/// Exponents vector.
-	template < PIRANHA_EXPO_VECTOR_TP_DECL >
-	class ExpoVector: public VectorKey<PIRANHA_EXPO_VECTOR_TP, ExpoVector<PIRANHA_EXPO_VECTOR_TP> >
+	/**
+	 * Up to InlineSize exponents are stored without memory allocation (see piranha::VectorKey).
+	 */
+	template <class T, int EchelonLevel, std::size_t InlineSize = 0>
+	class ExpoVector: public VectorKey<T, EchelonLevel, ExpoVector<PIRANHA_EXPO_VECTOR_TP>, InlineSize>
 	{
 		private:
 
-			typedef VectorKey<PIRANHA_EXPO_VECTOR_TP, ExpoVector<PIRANHA_EXPO_VECTOR_TP> > Ancestor;
+			typedef VectorKey<T, EchelonLevel, ExpoVector<PIRANHA_EXPO_VECTOR_TP>, InlineSize> Ancestor;
 
 			template <class SubSeries, class ArgsTuple>
 			class SubCache: public PowerCache<SubSeries, T, BaseSeriesArithmetics<SubSeries, ArgsTuple> >
@@ -22,26 +22,32 @@
 #define PIRANHA_POLYNOMIAL_MULTIPLIER_H
 
 
+#include "../arena.h"
 #include "../base_classes/base_series_multiplier.h"
 #include "../base_classes/coded_multiplier.h"
 #include "../coded_hash_table.h"
 #include "../exceptions.h"
+#include "../fft.h"
 #include "../integer_typedefs.h"
 #include "../memory.h"
+#include "../numerical_coefficients/double_cf.h"
 #include "../settings.h" // For debug and cache size.
 #include "../stats.h"
 #include "../type_traits.h"
 #include "../utils.h" // For iota.
+#include "../work_stealing_executor.h"
 
 #include <boost/numeric/conversion/cast.hpp>
-#include <boost/thread/barrier.hpp>
-#include <boost/thread/thread.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/type_traits/integral_constant.hpp>
+#include <boost/unordered_map.hpp>
 
+#include <cmath>
 #include <cstddef>
 #include <exception>
+#include <limits>
 #include <stdexcept>
+#include <type_traits>
 #include <utility> // For std::pair.
 #include <vector>
 #include <algorithm> // For std::max.
@@ -49,148 +55,6 @@
 
 namespace piranha
 {
-// Generic threaded vector multiplication.
-template <class Functor>
-struct ThreadedBlockedMultiplier
-{
-	ThreadedBlockedMultiplier(const std::size_t &nominal_block_size, const std::size_t &size1, const std::size_t &size2, const std::size_t &thread_id,
-		                        const std::size_t &thread_n, boost::barrier *barrier, std::size_t &cur_idx1_start, bool &breakout, Functor &func,
-		                        BlockSequence &idx_vector1, BlockSequence &idx_vector2)
-    : m_nominal_block_size(nominal_block_size), m_size1(size1), m_thread_id(thread_id), m_thread_n(thread_n),
-	  m_barrier(barrier), m_cur_idx1_start(cur_idx1_start), m_breakout(breakout), m_func(func), m_idx_vector1(idx_vector1), m_idx_vector2(idx_vector2)
-	{
-#ifdef _DEBUG
-		std::cout << "threaded_blocked_multiplier" << std::endl 
-			      << "nominal_block_size: " << nominal_block_size << std::endl 
-				  << "size1: " << size1 << std::endl
-				  << "size2: " << size2 << std::endl
-				  << "thread_id: " << thread_id << std::endl
-				  << "thread_n:  " << thread_n << std:: endl
-				  << "cur_idx1_start: " << cur_idx1_start <<std::endl
-				  << "breakout: " << breakout << std::endl
-				  <<std::flush;
-#endif
-		// Sanity checks.
-		PIRANHA_ASSERT(thread_n > 0 && thread_id < thread_n && (barrier || thread_n == 1));
-
-		// Numerical limits check. We need an extra block size buffer at the end to make sure we are able to
-		// represent all indices and sizes.
-		// TODO: we need to take care of extra thread_n blocks at the end, they must be representable. Maybe not, after all.
-		if (nominal_block_size > std::numeric_limits<std::size_t>::max() || size1 >= std::numeric_limits<std::size_t>::max() - nominal_block_size ||
-			size2 >= std::numeric_limits<std::size_t>::max() - nominal_block_size)
-		{
-			PIRANHA_THROW(std::overflow_error, "numerical overflow in threaded block multiplication");
-		}
-	}
-
-
-	void operator()()
-	{
-//		std::cout << "polynomial_multiplier::(): 1 : threadid = " << m_thread_id << std::endl << std::flush;
-
-		if (m_thread_id == 0)
-		{
-//			std::cout << "polynomial_multiplier::(): 2 : threadid = " << m_thread_id << std::endl << std::flush;
-			// The first thread is in charge of the initial setup of the indices vectors.
-			// TODO: exception handling, in case of both single and multi thread.
-			m_idx_vector1.resize(boost::numeric_cast<BlockSequence::size_type>(m_thread_n));
-			m_idx_vector2.resize(boost::numeric_cast<BlockSequence::size_type>(m_thread_n));
-			m_cur_idx1_start = 0;
-		}
-
-		sync();
-		//std::cout << "polynomial_multiplier::(): 3 : threadid = " << m_thread_id << std::endl << std::flush;
-		BlockSequence orig2(m_idx_vector2.size());
-		
-		while (m_cur_idx1_start != m_size1)
-		{
-			//std::cout << "polynomial_multiplier::(): 4 : threadid = " << m_thread_id << std::endl << std::flush;
-			//std::cout << "polynomial_multiplier::(): " << m_cur_idx1_start <<std::endl <<std::flush;
-			sync();
-			
-			if (m_thread_id == 0)
-			{
-				//std::cout << "polynomial_multiplier::(): 5 : threadid = " << m_thread_id << std::endl << std::flush;
-				m_func.blocksSetup(m_cur_idx1_start ,m_nominal_block_size, m_idx_vector1, m_idx_vector2);
-				m_breakout = false;
-			}
-
-			sync();
-			//std::cout << "polynomial_multiplier::(): 6 : threadid = " << m_thread_id << std::endl << std::flush;
-			const std::size_t i_start = m_idx_vector1[m_thread_id].first, i_end = m_idx_vector1[m_thread_id].second;
-			// Remember the original block sequence for the second series.
-			std::copy(m_idx_vector2.begin(), m_idx_vector2.end(), orig2.begin());
-			// Reset the wrap count.
-			std::size_t wrap_count = 0;
-
-			while (true)
-			{
-				//std::cout << "polynomial_multiplier::(): 7 : threadid = " << m_thread_id << std::endl << std::flush;;
-				const std::size_t j_start = m_idx_vector2[m_thread_id].first, j_end = m_idx_vector2[m_thread_id].second;
-				// NOTE: here maybe we can put a preemptive check on j start/end so that if the inner
-				// cycle is empty we skip this part altogether.
-				for (std::size_t i = i_start; i < i_end; ++i)
-				{
-					for (std::size_t j = j_start; j < j_end; ++j)
-					{
-						// TODO: truncation.
-						//std::cout << "polynomial_multiplier::(): 7a : threadid = " << m_thread_id << "  i/j = "  << i << "/" << j << std::endl << std::flush;;
-						m_func(i,j);
-						//std::cout << "polynomial_multiplier::(): 7b : threadid = " << m_thread_id << "  i/j = " << i << "/" << j << std::endl << std::flush;;
-					}
-				}
-
-				sync();
-				//std::cout << "polynomial_multiplier::(): 8 : threadid = " << m_thread_id << std::endl << std::flush;
-
-				if (m_thread_id == 0)
-				{
-					//std::cout << "polynomial_multiplier::(): 9 : threadid = " << m_thread_id << std::endl << std::flush;
-					if (!m_func.block2_advance(m_idx_vector1,m_idx_vector2,m_nominal_block_size,orig2,wrap_count))
-					{
-						//std::cout << "polynomial_multiplier::(): 9a : break  threadid = " << m_thread_id << std::endl << std::flush;
-						m_breakout = true;
-					}
-				}
-				//std::cout << "polynomial_multiplier::(): 10 : threadid = " << m_thread_id << std::endl << std::flush;
-				sync();
-				//std::cout << "polynomial_multiplier::(): 10a : threadid = " << m_thread_id << std::endl << std::flush;
-
-				if (m_breakout)
-				{
-					//std::cout << "polynomial_multiplier::(): 11 : threadid = " << m_thread_id << std::endl << std::flush;
-					break;
-				}
-			}
-		}
-		//std::cout << "polynomial_multiplier::(): 11 : threadid = " << m_thread_id << std::endl << std::flush;
-	}
-
-
-	void sync()
-	{
-		if (m_barrier)
-		{
-//			std::cout << "polynomial_multiplier::sync(): threadid = " << m_thread_id << std::endl << std::flush;
-			m_barrier->wait();
-//			std::cout << "polynomial_multiplier::sync(): finished : threadid = " << m_thread_id << std::endl << std::flush;
-		}
-	}
-
-
-	const std::size_t	m_nominal_block_size;
-	const std::size_t	m_size1;
-	const std::size_t	m_thread_id;
-	const std::size_t	m_thread_n;
-	boost::barrier	   *m_barrier;
-	std::size_t		   &m_cur_idx1_start;
-	bool			   &m_breakout;
-	Functor			   &m_func;
-	BlockSequence	   &m_idx_vector1;
-	BlockSequence	   &m_idx_vector2;
-};
-
-
 template <class Series1, class Series2, class ArgsTuple, class GenericTruncator>
 struct PolynomialVectorFunctor: public BaseCodedFunctor<Series1, Series2, ArgsTuple, GenericTruncator, PolynomialVectorFunctor<Series1, Series2, ArgsTuple, GenericTruncator> >
 {
@@ -222,83 +86,23 @@ struct PolynomialVectorFunctor: public BaseCodedFunctor<Series1, Series2, ArgsTu
 	}
 
 
-	void blocksSetup(std::size_t & currentIndexStart, std::size_t const blockSize, BlockSequence &indexVector1, BlockSequence &indexVector2)
-	{
-		if (currentIndexStart == 0)
-		{
-			initial_setup();
-		}
-		this->baseBlocksSetup(currentIndexStart, blockSize, indexVector1, indexVector2);
-	}
-
-
-	static const MaxFastInt &get_mem_pos(const MaxFastInt &n)
-	{
-		return n;
-	}
-
-
-	// Return the two intervals in indices in the output structure containing the results of
-	// one block-by-block multiplication.
-	std::pair<BlockInterval, BlockInterval> blocksToIntervals(BlockType const &b1, BlockType const &b2) const
-	{
-		PIRANHA_ASSERT(b1.first <= b1.second && b2.first <= b2.second);
-
-		// If at least one of the blocks is empty, then we won't be writing into any interval of indices.
-		if (b1.first == b1.second || b2.first == b2.second)
-        {
-			return std::make_pair(BlockInterval::empty(), BlockInterval::empty());
-		}
-
-		// In case of vector coded, we always end up with a single interval in output.
-		return std::make_pair(BlockInterval(this->m_ck1[b1.first] + this->m_ck2[b2.first], this->m_ck1[b1.second - 1] + this->m_ck2[b2.second - 1]),
-			                  BlockInterval::empty());
-	}
-
-
-	void initial_setup()
-	{
-		// Build the permutation vectors.
-		typedef std::vector<std::size_t>::size_type size_type;
-		
-        std::vector<std::size_t> perm1(boost::numeric_cast<size_type>(this->m_ck1.size()));
-		std::vector<std::size_t> perm2(boost::numeric_cast<size_type>(this->m_ck2.size()));
-		iota(perm1.begin(), perm1.end(), std::size_t(0));
-		iota(perm2.begin(), perm2.end(), std::size_t(0));
-
-		// Sort the permutation vectors.
-		typedef typename Ancestor::template IndirectSorter<PolynomialVectorFunctor> IndirectSorter;
-		
-        std::sort(perm1.begin(), perm1.end(), IndirectSorter(*this, this->m_ck1));
-		std::sort(perm2.begin(), perm2.end(), IndirectSorter(*this, this->m_ck2));
-
-		// Apply the permutations to the other vectors.
-		this->apply_permutation(perm1, this->m_tc1);
-		this->apply_permutation(perm1, this->m_ck1);
-		this->apply_permutation(perm1, this->m_t1);
-		this->apply_permutation(perm2, this->m_tc2);
-		this->apply_permutation(perm2, this->m_ck2);
-		this->apply_permutation(perm2, this->m_t2);
-	}
-
-
 	cf_type1 *m_vc_res;
 };
 
 
-template <class Series1, class Series2, class ArgsTuple, class GenericTruncator>
-struct PolynomialHashFunctor: public BaseCodedFunctor<Series1, Series2, ArgsTuple, GenericTruncator, PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator> >
+template <class Series1, class Series2, class ArgsTuple, class GenericTruncator, class Code = MaxFastInt>
+struct PolynomialHashFunctor: public BaseCodedFunctor<Series1, Series2, ArgsTuple, GenericTruncator, PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator, Code>, Code>
 {
 	typedef typename FinalCf<Series1>::Type cf_type1;
 	typedef typename FinalCf<Series2>::Type cf_type2;
 	typedef typename Series1::TermType term_type1;
 	typedef typename Series2::TermType term_type2;
-	typedef std::pair<cf_type1, MaxFastInt> cterm_type;
-	typedef BaseCodedFunctor<Series1, Series2, ArgsTuple, GenericTruncator, PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator> > Ancestor;
-	typedef coded_hash_table<cf_type1, MaxFastInt, CountingAllocator<char> > csht_type;
+	typedef std::pair<cf_type1, Code> cterm_type;
+	typedef BaseCodedFunctor<Series1, Series2, ArgsTuple, GenericTruncator, PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator, Code>, Code> Ancestor;
+	typedef coded_hash_table<cf_type1, Code, ArenaAllocator<char> > csht_type;
 
 	PolynomialHashFunctor(cterm_type &cterm, std::vector<cf_type1> &tc1, std::vector<cf_type2> &tc2,
-		std::vector<MaxFastInt> &ck1, std::vector<MaxFastInt> &ck2,
+		std::vector<Code> &ck1, std::vector<Code> &ck2,
 		std::vector<const term_type1 *> &t1, std::vector<const term_type2 *> &t2,
 		const GenericTruncator &trunc, csht_type *cms, const ArgsTuple &argsTuple)
     :  Ancestor(tc1, tc2, ck1, ck2, t1, t2, trunc, argsTuple), m_cterm(cterm), m_cms(cms)/*,m_overflow_terms()*/
@@ -334,48 +138,50 @@ struct PolynomialHashFunctor: public BaseCodedFunctor<Series1, Series2, ArgsTupl
 	}
 
 
-	MaxFastInt get_mem_pos(const MaxFastInt &n) const
-	{
-		// Assert on the convertibility to MaxFastInt. We should be sure because of the logic in coded_hash_table,
-		// but just in case...
-		PIRANHA_ASSERT(boost::numeric_cast<MaxFastInt>(m_cms->get_memory_position(n)) >= 0);
-		return m_cms->get_memory_position(n);
-	}
-
+	cterm_type		&m_cterm;
+	csht_type		*m_cms;
+	//std::vector<cterm_type>	&m_overflow_terms;
+};
 
-	// Return the two intervals in indices in the output structure containing the results of
-	// one block-by-block multiplication.
-	std::pair<BlockInterval, BlockInterval> blocks_to_intervals(BlockType const &b1, BlockType const &b2) const
-	{
-		PIRANHA_ASSERT(b1.first <= b1.second && b2.first <= b2.second);
 
-		// If at least one of the blocks is empty, then we won't be writing into any interval of indices.
-		if (b1.first == b1.second || b2.first == b2.second)
-		{
-			return std::make_pair(BlockInterval::empty(), BlockInterval::empty());
-		}
+template <class Multiplier, class Series1, class ArgsTuple>
+struct PolynomialVectorDecoder
+{
+	typedef typename FinalCf<Series1>::Type cf_type1;
+	typedef typename Series1::TermType term_type1;
 
-		BlockInterval tmp(get_mem_pos(this->m_ck1[b1.first])      + get_mem_pos(this->m_ck2[b2.first]),
-			              get_mem_pos(this->m_ck1[b1.second - 1]) + get_mem_pos(this->m_ck2[b2.second - 1]));
+	// Polynomial terms are always canonical, hence distinct codes yield distinct terms.
+	static const bool uniqueTerms = true;
 
-		const MaxFastInt ht_size = boost::numeric_cast<MaxFastInt>(m_cms->get_vector_size());
+	PolynomialVectorDecoder(Multiplier const &multiplier, cf_type1 *vc_res, const ArgsTuple &argsTuple)
+        : m_multiplier(multiplier), m_vc_res(vc_res), m_argsTuple(argsTuple)
+	{}
 
-		PIRANHA_ASSERT(ht_size > 0 && tmp.lower() >= 0 && tmp.upper() >= 0);
 
-		if (tmp.lower() >= ht_size || tmp.upper() < ht_size)
-		{
-			PIRANHA_ASSERT(tmp.upper() / 2 < ht_size);
-			return std::make_pair(BlockInterval(tmp.lower() % ht_size,tmp.upper() % ht_size), BlockInterval::empty());
-		} else
+	template <class Out>
+	void operator()(MaxFastInt const lower, MaxFastInt const upper, Out &out) const
+	{
+		term_type1 tmp_term;
+		for (MaxFastInt i = lower; i < upper; ++i)
 		{
-			return std::make_pair(BlockInterval(tmp.lower(), ht_size - 1), BlockInterval(0, tmp.upper() % ht_size));
+			// Take a shortcut and check for ignorability of the coefficient here.
+			// This way we avoid decodification, and all the series term insertion yadda-yadda.
+			if (!m_vc_res[i].isIgnorable(m_argsTuple))
+			{
+				m_multiplier.decode(m_vc_res[i], i, tmp_term);
+				if (!tmp_term.isCanonical(m_argsTuple))
+				{
+					tmp_term.canonicalise(m_argsTuple);
+				}
+				out.push_back(tmp_term);
+			}
 		}
 	}
 
 
-	cterm_type		&m_cterm;
-	csht_type		*m_cms;
-	//std::vector<cterm_type>	&m_overflow_terms;
+	Multiplier const	&m_multiplier;
+	cf_type1			*m_vc_res;
+	const ArgsTuple		&m_argsTuple;
 };
 
 
@@ -450,121 +256,538 @@ struct polynomial_multiplier
                 const ArgsTupleType &argsTuple = this->argsTuple;
 				cf_type1 *vc_res =  &vc[0] - this->m_fast_h.lower();
 
-				// Find out a suitable block size.
-				const std::size_t block_size = this->template computeBlockSize<sizeof(cf_type1)>();
-
-				PIRANHA_DEBUG(std::cout << "Block size: " << block_size << '\n');
-				PIRANHA_DEBUG(std::cout << "Block size: " << block_size << '\n');
-				
-                // Perform multiplication.
+				// Perform multiplication.
 				typedef PolynomialVectorFunctor<Series1, Series2, ArgsTuple, GenericTruncator> VectorFunctorType;
-				VectorFunctorType vm(tc1, tc2, this->m_ckeys1, this->m_ckeys2a, t1, t2, trunc, vc_res, argsTuple);
-//				const std::size_t nthread = settings::get_nthread();
-				//TODO:GUT corrected below. There are problems with the number of threads in several places. This is one.
+				typedef CodedSquaringFunctor<VectorFunctorType> SquaringFunctorType;
 				const std::size_t nthread = std::min(settings::get_nthread(), std::min(size1, size2));
-	const boost::posix_time::ptime time0 = boost::posix_time::microsec_clock::local_time();
-				
-                // Variables needed by the multiplier.
-				BlockSequence s1;
-                BlockSequence s2;
-				bool breakout = false;
-				std::size_t cur_idx1_start = 0;
-				// TODO: probably we need to rethink a bit this, taking into account also the number of threads. Also drop the truncation limitation.
-				if (trunc.isEffective() || (this->terms1.size() * this->terms2.size()) <= 400 || nthread == 1) 
-                {
-					stats::trace_stat("mult_st: block-polynomial", std::size_t(0), increment);
-					ThreadedBlockedMultiplier<VectorFunctorType> t(block_size, size1, size2, 0, 1, 0, cur_idx1_start, breakout, vm, s1, s2);
-					t();
-				} else 
-                {
-					PIRANHA_DEBUG(std::cout << "using " << nthread << " threads\n");
-					stats::trace_stat("mult_mt: block-polynomial", std::size_t(0), increment);
-					boost::thread_group tg;
-					boost::barrier b(static_cast<unsigned int>(nthread));
-					for (std::size_t i = 0; i < nthread; ++i) 
+
+				if (performFFTMultiplication(tc1, tc2, vc_res, trunc))
+				{
+					stats::trace_stat("mult_st: fft", std::size_t(0), increment);
+				} else
+				{
+					const bool squaring = this->isSquaring();
+					std::vector<cf_type2> tc2Doubled;
+					if (squaring)
 					{
-						tg.create_thread(ThreadedBlockedMultiplier<VectorFunctorType>(block_size, size1, size2, i, nthread, &b, cur_idx1_start, breakout, vm, s1, s2));
+						stats::trace_stat("mult_square", std::size_t(0), increment);
+						tc2Doubled = this->doubledCoefficients(tc2);
 					}
-					tg.join_all();
-				}
-		//std::cout << "Elapsed time: " << (double)(boost::posix_time::microsec_clock::local_time() - time0).total_microseconds() << " micro seconds" <<std::endl;
-				PIRANHA_DEBUG(std::cout << "Done multiplying\n");
+					SquaringFunctorType vm(VectorFunctorType(tc1, tc2, this->m_ckeys1, this->m_ckeys2a, t1, t2, trunc, vc_res, argsTuple),
+					                       VectorFunctorType(tc1, tc2Doubled, this->m_ckeys1, this->m_ckeys2a, t1, t2, trunc, vc_res, argsTuple), squaring);
 
-				const MaxFastInt i_f = this->m_fast_h.upper();
-				// Decode and insert the results into return value.
-				term_type1 tmp_term;
-				for (MaxFastInt i = this->m_fast_h.lower(); i <= i_f; ++i)
-				{
-					// Take a shortcut and check for ignorability of the coefficient here.
-					// This way we avoid decodification, and all the series term insertion yadda-yadda.
-					if (!vc_res[i].isIgnorable(argsTuple))
+					// The pairs cut by the truncator are never visited, hence only the others count towards threading.
+					const std::vector<std::size_t> row_ends = this->computeRowEnds(t1, t2, trunc);
+					if (this->countPairs(row_ends) <= settings::getMultiplicationThresholds().threadedCoded || nthread == 1)
 					{
-						this->decode(vc_res[i], i, tmp_term);
-						if (!tmp_term.isCanonical(argsTuple))
+						stats::trace_stat("mult_st: block-polynomial", std::size_t(0), increment);
+						// Find out suitable block sizes.
+						const typename ancestor::BlockSizes block_sizes = this->template computeBlockSizes<sizeof(cf_type1)>();
+
+						PIRANHA_DEBUG(std::cout << "Block sizes: " << block_sizes[0] << ',' << block_sizes[1] << ',' << block_sizes[2] << '\n');
+
+						if (squaring)
 						{
-							tmp_term.canonicalise(argsTuple);
+							this->blockedSquaring(block_sizes, row_ends, vm);
+						} else
+						{
+							this->blockedMultiplication(block_sizes, row_ends, vm);
+						}
+					} else
+					{
+						// Each task handles a disjoint range of the output codes, hence a disjoint region of vc.
+						PIRANHA_DEBUG(std::cout << "using " << nthread << " threads\n");
+						stats::trace_stat("mult_mt: block-polynomial", std::size_t(0), increment);
+
+						const CodeRangeIndex index1(this->m_ckeys1);
+						const CodeRangeIndex index2(this->m_ckeys2a);
+						const std::vector<MaxFastInt> splits = computeCodeSplits(this->m_ckeys1, index2, this->template vectorCodedTasks<sizeof(cf_type1)>(nthread));
+
+						std::vector<CodeRangeTask<SquaringFunctorType> > tasks;
+						tasks.reserve(splits.size() - 1);
+						for (std::size_t i = 0; i < splits.size() - 1; ++i)
+						{
+							tasks.push_back(CodeRangeTask<SquaringFunctorType>(vm, index1, index2, row_ends, splits[i], splits[i + 1]));
 						}
-						this->retval.insert(tmp_term, argsTuple);
+
+						WorkStealingExecutor executor(nthread);
+						executor.run(tasks);
+						executor.traceStats("mult_mt:");
 					}
 				}
+
+				PIRANHA_DEBUG(std::cout << "Done multiplying\n");
+
+				// Decode and insert the results into return value.
+				const PolynomialVectorDecoder<get_type, Series1, ArgsTuple> decoder(*this, vc_res, argsTuple);
+				this->vectorDecodeAndInsert(decoder, settings::get_nthread());
 				PIRANHA_DEBUG(std::cout << "Done polynomial vector coded.\n");
 				return true;
 			}
 
 
-			template <class GenericTruncator>
+			/// Hash coded multiplication, with codes of type Code (MaxFastInt, or MaxWideInt for the wide coding tier).
+			template <class Code, class GenericTruncator>
 			void performHashCodedMultiplication(std::vector<cf_type1>           &tc1, std::vector<cf_type2> &tc2,
 				                                std::vector<const term_type1 *> &t1,  std::vector<const term_type2 *> &t2,
                                                 GenericTruncator const &truncator)
 			{
-				typedef coded_hash_table<cf_type1, MaxFastInt, CountingAllocator<char> > csht;
+				typedef coded_hash_table<cf_type1, Code, ArenaAllocator<char> > csht;
+				typedef PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator, Code> HashFunctorType;
+				typedef CodedSquaringFunctor<HashFunctorType> SquaringFunctorType;
 
-				typedef typename csht::iterator c_iterator;
-				stats::trace_stat("mult_st: hash", std::size_t(0), increment);
 				// Let's find a sensible size hint.
-				const std::size_t n_codes = boost::numeric_cast<std::size_t>(boost::numeric::width(this->m_fast_h) + 1);
-				const std::size_t size_hint = static_cast<std::size_t>(
-					std::max<double>(this->m_density1,this->m_density2) * n_codes);
+				const std::size_t size_hint = this->hashSizeHint();
+				std::vector<Code> &ck1 = this->template codes1<Code>();
+				std::vector<Code> &ck2 = this->template codes2a<Code>();
 				const std::size_t size1 = this->terms1.size(); 
                 const std::size_t size2 = this->terms2.size();
 
 				PIRANHA_ASSERT(size1 && size2);
 
 				const ArgsTupleType &argsTuple = this->argsTuple;
-				csht cms(size_hint);
-				// Find out a suitable block size.
-				const std::size_t block_size = this->template computeBlockSize<sizeof(std::pair<cf_type1, MaxFastInt>)>();
+				const std::size_t nthread = std::min(settings::get_nthread(), std::min(size1, size2));
 
-				PIRANHA_DEBUG(std::cout << "Block size: " << block_size << '\n');
+				const bool squaring = this->isSquaring();
+				std::vector<cf_type2> tc2Doubled;
+				if (squaring)
+				{
+					stats::trace_stat("mult_square", std::size_t(0), increment);
+					tc2Doubled = this->doubledCoefficients(tc2);
+				}
 
-                //std::cout << "Block size: " << block_size << '\n';
-                const boost::posix_time::ptime time0 = boost::posix_time::microsec_clock::local_time();
-				
-                std::pair<cf_type1, MaxFastInt> cterm;
-				PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator> hm(cterm, tc1, tc2, this->m_ckeys1, this->m_ckeys2a, t1, t2, truncator, &cms, argsTuple);
+				// The hash tables, and the tables they are resized from, are all given back at the end of the multiplication.
+				Arena arena(this->template hashArenaChunkSize<sizeof(std::pair<cf_type1, Code>)>());
+				const ArenaAllocator<char> allocator(arena);
 
-				this->blockedMultiplication(block_size, size1, size2, hm);
-                
-                //std::cout << "Elapsed time: " << (double)(boost::posix_time::microsec_clock::local_time() - time0).total_microseconds() / 1000 << '\n';
+				// The pairs cut by the truncator are never visited, hence only the others count towards threading.
+				const std::vector<std::size_t> row_ends = this->computeRowEnds(t1, t2, truncator);
+				if (this->countPairs(row_ends) <= settings::getMultiplicationThresholds().threadedCoded || nthread == 1)
+				{
+					stats::trace_stat("mult_st: hash", std::size_t(0), increment);
+					csht cms(size_hint, allocator);
+					// Find out suitable block sizes.
+					const typename ancestor::BlockSizes block_sizes = this->template computeBlockSizes<sizeof(std::pair<cf_type1, Code>)>();
 
-				PIRANHA_DEBUG(std::cout << "Done polynomial hash coded multiplying\n");
+					PIRANHA_DEBUG(std::cout << "Block sizes: " << block_sizes[0] << ',' << block_sizes[1] << ',' << block_sizes[2] << '\n');
 
-                // Decode and insert into retval.
-				// TODO: add debug info about cms' size here.
+					std::pair<cf_type1, Code> cterm;
+					SquaringFunctorType hm(HashFunctorType(cterm, tc1, tc2, ck1, ck2, t1, t2, truncator, &cms, argsTuple),
+					                       HashFunctorType(cterm, tc1, tc2Doubled, ck1, ck2, t1, t2, truncator, &cms, argsTuple), squaring);
+
+					if (squaring)
+					{
+						this->blockedSquaring(block_sizes, row_ends, hm);
+					} else
+					{
+						this->blockedMultiplication(block_sizes, row_ends, hm);
+					}
+
+					PIRANHA_DEBUG(std::cout << "Done polynomial hash coded multiplying\n");
+
+					this->reserveResult(cms.size());
+					insertHashCodedResults(cms);
+				} else
+				{
+					// Split the output code space into disjoint ranges, each one handled by a task
+					// accumulating into its own hash table. Hence there is no need to lock anything
+					// and the tables can be decoded independently at the end.
+					PIRANHA_DEBUG(std::cout << "using " << nthread << " threads\n");
+					stats::trace_stat("mult_mt: hash", std::size_t(0), increment);
+
+					const BasicCodeRangeIndex<Code> index1(ck1);
+					const BasicCodeRangeIndex<Code> index2(ck2);
+					const std::vector<Code> splits = computeCodeSplits(ck1, index2, nthread * coded_ancestor::tasksPerThread);
+					const std::size_t n = splits.size() - 1;
+
+					std::vector<csht> tables(n, csht(size_hint / n, allocator));
+					std::vector<std::pair<cf_type1, Code> > cterms(n);
+					std::vector<CodeRangeTask<SquaringFunctorType, Code> > tasks;
+					tasks.reserve(n);
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						tasks.push_back(CodeRangeTask<SquaringFunctorType, Code>(
+							SquaringFunctorType(HashFunctorType(cterms[i], tc1, tc2, ck1, ck2, t1, t2, truncator, &tables[i], argsTuple),
+							                    HashFunctorType(cterms[i], tc1, tc2Doubled, ck1, ck2, t1, t2, truncator, &tables[i], argsTuple), squaring),
+							index1, index2, row_ends, splits[i], splits[i + 1]));
+					}
+
+					WorkStealingExecutor executor(nthread);
+					executor.run(tasks);
+					executor.traceStats("mult_mt:");
+
+					PIRANHA_DEBUG(std::cout << "Done polynomial hash coded multiplying\n");
+
+					std::size_t nterms = 0;
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						nterms += tables[i].size();
+					}
+					this->reserveResult(nterms);
+
+					for (std::size_t i = 0; i < n; ++i)
+					{
+						insertHashCodedResults(tables[i]);
+					}
+				}
+
+				PIRANHA_DEBUG(std::cout << "Done polynomial hash coded\n");
+			}
+
+
+			/// Heap coded multiplication, with codes of type Code.
+			/**
+			 * Monagan and Pearce's heap merge: the terms are visited in code order, and the pending products are kept
+			 * in a binary heap holding at most one pair per term of the first series. All the products sharing a code leave
+			 * the heap one after the other, hence each coefficient of the result is complete when it is extracted and
+			 * the result is produced in code order, without any intermediate table.
+			 */
+			template <class Code, class GenericTruncator>
+			bool performHeapCodedMultiplication(std::vector<cf_type1>           &tc1, std::vector<cf_type2> &tc2,
+			                                    std::vector<const term_type1 *> &t1,  std::vector<const term_type2 *> &t2,
+			                                    GenericTruncator const &truncator)
+			{
+				stats::trace_stat("mult_st: heap", std::size_t(0), increment);
+
+				const std::vector<Code> &ck1 = this->template codes1<Code>();
+				const std::vector<Code> &ck2 = this->template codes2a<Code>();
+				const std::size_t size1 = this->terms1.size();
+				const std::size_t size2 = this->terms2.size();
+
+				PIRANHA_ASSERT(size1 && size2);
+
+				const ArgsTupleType &argsTuple = this->argsTuple;
+				// Order of the terms by code. Without truncation they are sorted already, by key_revlex_comparison().
+				const std::vector<std::size_t> p1 = codeOrder(ck1);
+				const std::vector<std::size_t> p2 = codeOrder(ck2);
+
+				// Pair of the p1[i]-th and p2[j]-th terms.
+				struct HeapEntry
+				{
+					Code		code;
+					std::size_t	i;
+					std::size_t	j;
+
+					// Smallest code on top of the heap.
+					bool operator<(HeapEntry const &other) const
+					{
+						return code > other.code;
+					}
+				};
+
+				std::vector<HeapEntry> heap;
+				heap.reserve(size1);
+				heap.push_back(HeapEntry{ck1[p1[0]] + ck2[p2[0]], 0, 0});
+
+				cf_type1 cf;
+				term_type1 tmp_term;
+				// Pairs and distinct codes extracted from the heap.
+				std::size_t pairs = 0;
+				std::size_t codes = 0;
+				while (!heap.empty())
+				{
+					const Code code = heap.front().code;
+					bool assigned = false;
+					++codes;
+					do
+					{
+						const HeapEntry entry = heap.front();
+						++pairs;
+						const std::size_t n1 = p1[entry.i];
+						const std::size_t n2 = p2[entry.j];
+						if (!truncator.skip(&t1[n1], &t2[n2]))
+						{
+							if (assigned)
+							{
+								cf.addmul(tc1[n1], tc2[n2], argsTuple);
+							} else
+							{
+								cf = tc1[n1];
+								cf.multBy(tc2[n2], argsTuple);
+								assigned = true;
+							}
+						}
+
+						// Each pair is replaced by its successor in the row, which saves a push into the heap.
+						if (entry.j + 1 < size2)
+						{
+							heap.front() = HeapEntry{ck1[n1] + ck2[p2[entry.j + 1]], entry.i, entry.j + 1};
+							siftDown(heap);
+						} else
+						{
+							std::pop_heap(heap.begin(), heap.end());
+							heap.pop_back();
+						}
+						// The first pair of a row brings in the next row. Hence each row has at most one pair in the heap.
+						if (entry.j == 0 && entry.i + 1 < size1)
+						{
+							heap.push_back(HeapEntry{ck1[p1[entry.i + 1]] + ck2[p2[0]], entry.i + 1, 0});
+							std::push_heap(heap.begin(), heap.end());
+						}
+					} while (!heap.empty() && heap.front().code == code);
+
+					if (assigned && !cf.isIgnorable(argsTuple))
+					{
+						this->decode(cf, static_cast<Code>(code + 2 * this->template minCode<Code>()), tmp_term);
+						if (!tmp_term.isCanonical(argsTuple))
+						{
+							tmp_term.canonicalise(argsTuple);
+						}
+						this->insertUniqueResult(tmp_term);
+					}
+				}
+				stats::trace_stat("mult_st: heap pairs", std::size_t(0), [pairs](const std::size_t x) -> std::size_t { return x + pairs; });
+				stats::trace_stat("mult_st: heap codes", std::size_t(0), [codes](const std::size_t x) -> std::size_t { return x + codes; });
+
+				PIRANHA_DEBUG(std::cout << "Done polynomial heap coded\n");
+				return true;
+			}
+
+
+			/// Split coded multiplication.
+			/**
+			 * The terms are grouped by their outer codes, and each pair of groups is multiplied through
+			 * hash coded multiplication of the inner codes, into the hash table of the resulting outer codes.
+			 */
+			template <class GenericTruncator>
+			void performSplitCodedMultiplication(std::vector<cf_type1>           &tc1, std::vector<cf_type2> &tc2,
+				                                 std::vector<const term_type1 *> &t1,  std::vector<const term_type2 *> &t2,
+				                                 GenericTruncator const &truncator)
+			{
+				typedef coded_hash_table<cf_type1, MaxFastInt, ArenaAllocator<char> > csht;
+				typedef PolynomialHashFunctor<Series1, Series2, ArgsTuple, GenericTruncator> HashFunctorType;
+				typedef typename coded_ancestor::SplitBucket SplitBucket;
+				typedef boost::unordered_map<std::vector<MaxFastInt>, csht> TableMap;
+
+				stats::trace_stat("mult_st: split", std::size_t(0), increment);
+
+				const ArgsTupleType &argsTuple = this->argsTuple;
+				const std::vector<SplitBucket> buckets1 = coded_ancestor::splitBuckets(this->m_split_ckeys1);
+				const std::vector<SplitBucket> buckets2 = coded_ancestor::splitBuckets(this->m_split_ckeys2a);
+
+				Arena arena(this->template hashArenaChunkSize<sizeof(std::pair<cf_type1, MaxFastInt>)>());
+				const ArenaAllocator<char> allocator(arena);
+				TableMap tables;
+				std::vector<MaxFastInt> outer;
+				std::pair<cf_type1, MaxFastInt> cterm;
+				for (std::size_t b1 = 0; b1 < buckets1.size(); ++b1)
+				{
+					for (std::size_t b2 = 0; b2 < buckets2.size(); ++b2)
+					{
+						coded_ancestor::splitOuterSum(buckets1[b1].outer, buckets2[b2].outer, outer);
+						typename TableMap::iterator table = tables.find(outer);
+						if (table == tables.end())
+						{
+							table = tables.insert(std::make_pair(outer, csht(allocator))).first;
+						}
+						HashFunctorType hm(cterm, tc1, tc2, this->m_split_ckeys1[0], this->m_split_ckeys2a[0], t1, t2, truncator, &table->second, argsTuple);
+						for (std::size_t i = 0; i < buckets1[b1].terms.size(); ++i)
+						{
+							for (std::size_t j = 0; j < buckets2[b2].terms.size(); ++j)
+							{
+								hm(buckets1[b1].terms[i], buckets2[b2].terms[j]);
+							}
+						}
+					}
+				}
+
+				PIRANHA_DEBUG(std::cout << "Done polynomial split coded multiplying\n");
+
+				std::size_t nterms = 0;
+				for (typename TableMap::iterator it = tables.begin(); it != tables.end(); ++it)
+				{
+					nterms += it->second.size();
+				}
+				this->reserveResult(nterms);
+
+				for (typename TableMap::iterator it = tables.begin(); it != tables.end(); ++it)
+				{
+					insertSplitCodedResults(it->first, it->second);
+				}
+			}
+
+		private:
+
+			// Largest error of FFT multiplication, relative to the smallest product of two input coefficients.
+			static constexpr double fftTolerance = 1E-6;
+
+
+			// FFT multiplication into the array of vector coded multiplication, for double precision coefficients.
+			/**
+			 * The coefficients are laid out in dense arrays indexed by code, i.e., the codes are a Kronecker substitution,
+			 * and the arrays are convolved through piranha::FFT. The FFT is used only when settings::MultiplicationAlgorithm::FFT
+			 * is selected, without truncation, when the number of term pairs is above the fftCost threshold times N log2(N) and
+			 * the error bound of the convolution is below fftTolerance times the smallest product of two input coefficients.
+			 * Otherwise the direct vector coded kernel runs.
+			 *
+			 * Drop rule: the results whose magnitude is not above the error bound cannot be told apart from zero, hence they are
+			 * discarded. The bound is at least eps * |a|_2 * |b|_2, i.e., many orders of magnitude above settings::get_numerical_zero(),
+			 * which alone decides the ignorability of the coefficients in the other kernels. A small true coefficient arising from
+			 * the cancellation of large products may thus be lost, and this is why the FFT is never chosen automatically.
+			 */
+			template <class GenericTruncator>
+			bool performFFTMultiplication(std::vector<cf_type1> const &tc1, std::vector<cf_type2> const &tc2, cf_type1 *vc_res, GenericTruncator const &trunc)
+			{
+				if constexpr (!std::is_same_v<cf_type1, double_cf> || !std::is_same_v<cf_type2, double_cf>)
+				{
+					return false;
+				} else
+				{
+					if (settings::getMultiplicationAlgorithm() != settings::MultiplicationAlgorithm::FFT || trunc.isEffective())
+					{
+						return false;
+					}
+
+					const std::vector<MaxFastInt> &ck1 = this->m_ckeys1;
+					const std::vector<MaxFastInt> &ck2 = this->m_ckeys2a;
+					const MaxFastInt min1 = *std::min_element(ck1.begin(), ck1.end());
+					const MaxFastInt min2 = *std::min_element(ck2.begin(), ck2.end());
+					const std::size_t width1 = static_cast<std::size_t>(*std::max_element(ck1.begin(), ck1.end()) - min1) + 1;
+					const std::size_t width2 = static_cast<std::size_t>(*std::max_element(ck2.begin(), ck2.end()) - min2) + 1;
+					const std::size_t n = FFT::length(width1, width2);
+					const double pairs = static_cast<double>(ck1.size()) * static_cast<double>(ck2.size());
+					if (pairs < settings::getMultiplicationThresholds().fftCost * static_cast<double>(n) * std::log2(static_cast<double>(n)))
+					{
+						return false;
+					}
+
+					std::vector<double> a(width1), b(width2), c;
+					double norm1 = 0, norm2 = 0;
+					double smallest1 = std::numeric_limits<double>::max(), smallest2 = std::numeric_limits<double>::max();
+					for (std::size_t i = 0; i < ck1.size(); ++i)
+					{
+						const double value = tc1[i].get_value();
+						a[static_cast<std::size_t>(ck1[i] - min1)] = value;
+						norm1 += value * value;
+						smallest1 = std::min(smallest1, std::abs(value));
+					}
+					for (std::size_t j = 0; j < ck2.size(); ++j)
+					{
+						const double value = tc2[j].get_value();
+						b[static_cast<std::size_t>(ck2[j] - min2)] = value;
+						norm2 += value * value;
+						smallest2 = std::min(smallest2, std::abs(value));
+					}
+					const double bound = FFT::errorBound(n, std::sqrt(norm1), std::sqrt(norm2));
+					if (!(bound <= fftTolerance * smallest1 * smallest2))
+					{
+						return false;
+					}
+
+					FFT::convolution(a, b, c);
+					const ArgsTupleType &argsTuple = this->argsTuple;
+					for (std::size_t k = 0; k < c.size(); ++k)
+					{
+						if (std::abs(c[k]) > bound)
+						{
+							vc_res[min1 + min2 + static_cast<MaxFastInt>(k)] = cf_type1(c[k], argsTuple);
+						}
+					}
+					return true;
+				}
+			}
+
+
+			// Restore the heap property after the replacement of the top element of a heap built through std::push_heap().
+			template <class Entry>
+			static void siftDown(std::vector<Entry> &heap)
+			{
+				const std::size_t size = heap.size();
+				const Entry entry = heap.front();
+				std::size_t k = 0;
+				while (true)
+				{
+					std::size_t child = 2 * k + 1;
+					if (child >= size)
+					{
+						break;
+					}
+					if (child + 1 < size && heap[child] < heap[child + 1])
+					{
+						++child;
+					}
+					if (!(entry < heap[child]))
+					{
+						break;
+					}
+					heap[k] = heap[child];
+					k = child;
+				}
+				heap[k] = entry;
+			}
+
+
+			// Indices of the codes in increasing code order.
+			template <class Code>
+			static std::vector<std::size_t> codeOrder(const std::vector<Code> &codes)
+			{
+				std::vector<std::size_t> retval(codes.size());
+				for (std::size_t i = 0; i < retval.size(); ++i)
+				{
+					retval[i] = i;
+				}
+				if (!std::is_sorted(codes.begin(), codes.end()))
+				{
+					std::sort(retval.begin(), retval.end(), [&codes](std::size_t const n1, std::size_t const n2) { return codes[n1] < codes[n2]; });
+				}
+				return retval;
+			}
+
+
+			// Same as insertHashCodedResults(), for the hash table of the outer codes of split coded multiplication.
+			// The pair of outer and inner codes identifies the term, hence the decoded terms are unique.
+			template <class CodedHashTable>
+			void insertSplitCodedResults(const std::vector<MaxFastInt> &outer, CodedHashTable &cms)
+			{
+				typedef typename CodedHashTable::iterator c_iterator;
+
+				const ArgsTupleType &argsTuple = this->argsTuple;
 				const c_iterator c_it_f = cms.end();
 				term_type1 tmp_term;
 
 				for (c_iterator c_it = cms.begin(); c_it != c_it_f; ++c_it)
 				{
-					this->decode(c_it->first, c_it->second + 2 * this->m_fast_h.lower(), tmp_term);
+					if (c_it->first.isIgnorable(argsTuple))
+					{
+						continue;
+					}
+					this->decodeSplit(c_it->first, c_it->second, outer, tmp_term);
 					if (!tmp_term.isCanonical(argsTuple)) 
 					{
 						tmp_term.canonicalise(argsTuple);
 					}
-					this->retval.insert(tmp_term, argsTuple);
+					this->insertUniqueResult(tmp_term);
 				}
+			}
 
-				PIRANHA_DEBUG(std::cout << "Done polynomial hash coded\n");
+
+			// Decode the content of a coded hash table and insert it into retval. Codes are unique, hence so are
+			// the decoded terms, and the duplicate lookup can be skipped.
+			template <class CodedHashTable>
+			void insertHashCodedResults(CodedHashTable &cms)
+			{
+				typedef typename CodedHashTable::iterator c_iterator;
+				typedef typename CodedHashTable::KeyType Code;
+
+				const ArgsTupleType &argsTuple = this->argsTuple;
+				// TODO: add debug info about cms' size here.
+				const c_iterator c_it_f = cms.end();
+				term_type1 tmp_term;
+
+				for (c_iterator c_it = cms.begin(); c_it != c_it_f; ++c_it)
+				{
+					// Coefficients may have cancelled out during accumulation.
+					if (c_it->first.isIgnorable(argsTuple))
+					{
+						continue;
+					}
+					this->decode(c_it->first, static_cast<Code>(c_it->second + 2 * this->template minCode<Code>()), tmp_term);
+					if (!tmp_term.isCanonical(argsTuple)) 
+					{
+						tmp_term.canonicalise(argsTuple);
+					}
+					this->insertUniqueResult(tmp_term);
+				}
 			}
 	};
 };
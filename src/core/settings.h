@@ -47,7 +47,9 @@ namespace piranha
 				AUTOMATIC    = 0,
 				PLAIN        = 1,
 				VECTOR_CODED = 2,
-				HASH_CODED   = 3
+				HASH_CODED   = 3,
+				HEAP_CODED   = 4,
+				FFT          = 5
 
 			};
 
@@ -59,15 +61,43 @@ namespace piranha
 				case MultiplicationAlgorithm::PLAIN:		return "plain";
 				case MultiplicationAlgorithm::VECTOR_CODED: return "vector coded";
 				case MultiplicationAlgorithm::HASH_CODED:   return "hash coded";
+				case MultiplicationAlgorithm::HEAP_CODED:   return "heap coded";
+				case MultiplicationAlgorithm::FFT:          return "fft";
 				};
 			}
 
 			static inline constexpr std::underlying_type_t<MultiplicationAlgorithm> minAlgorithm = 0; //TODO: automatically determin it's values
-			static inline constexpr std::underlying_type_t<MultiplicationAlgorithm> maxAlgorithm = 3;
+			static inline constexpr std::underlying_type_t<MultiplicationAlgorithm> maxAlgorithm = 5;
+
+			/// Engine of the real, rational and negative integer powers of series (see piranha::BinomialExponentiation).
+			/**
+			 * The automatic selection uses the J.C.P. Miller recurrence when the degree truncator grades the series,
+			 * the binomial expansion otherwise.
+			 */
+			enum class PowerAlgorithm
+			{
+				AUTOMATIC = 0,
+				BINOMIAL  = 1,
+				MILLER    = 2
+			};
+
+			inline static std::string toString(PowerAlgorithm algo)
+			{
+				switch (algo) {
+
+				case PowerAlgorithm::AUTOMATIC: return "automatic";
+				case PowerAlgorithm::BINOMIAL:  return "binomial";
+				case PowerAlgorithm::MILLER:    return "miller";
+				};
+			}
 
-			static BaseCountingAllocator::CounterType::value_type get_used_memory()
+			/// Memory used by series, in bytes.
+			/**
+			 * Exact for the calling thread, while the other threads may not have counted up to ThreadMemoryCounter::batchSize bytes each.
+			 */
+			static std::size_t get_used_memory()
 			{
-				return BaseCountingAllocator::count();
+				return ThreadMemoryCounter::total();
 			}
 
 
@@ -110,8 +140,23 @@ namespace piranha
 
 			/// Get Piranha version.
 			static const char *get_version(); // no stl interface over dll border
-			/// Cache size in kilobytes.
+			/// Cache size in kilobytes, as configured at build time.
+			/**
+			 * Used as fallback for the cache levels that cannot be detected at runtime (see get_cache_size()).
+			 */
 			static const std::size_t cache_size;// = _PIRANHA_CACHE_SIZE;
+			/// Number of cache levels managed by piranha.
+			static inline constexpr unsigned cacheLevels = 3;
+			/// Size in kilobytes of the data cache of the given level, in the [1,3] range.
+			static std::size_t get_cache_size(const unsigned &);
+			/// Override the detected size in kilobytes of the data cache of the given level.
+			static void set_cache_size(const unsigned &, const std::size_t &);
+			/// Detect the cache sizes of the host, discarding the values set through set_cache_size().
+			/**
+			 * On Linux the sizes are read from sysfs, on Windows they are queried from the operating system.
+			 * Levels which cannot be detected fall back to the build time values.
+			 */
+			static void detect_cache_sizes();
 //			static_assert(cache_size > 0 && lg<cache_size>::value > 1, "Invalid value for cache size.");
 			static bool blocker;
 			static std::size_t get_max_pretty_print_size();
@@ -135,6 +180,78 @@ namespace piranha
 			}
 
 
+			static PowerAlgorithm getPowerAlgorithm()
+			{
+				return powerAlgorithm;
+			}
+
+
+			static void setPowerAlgorithm(PowerAlgorithm algorithm)
+			{
+				if (algorithm != PowerAlgorithm::AUTOMATIC && algorithm != PowerAlgorithm::BINOMIAL && algorithm != PowerAlgorithm::MILLER)
+                {
+					PIRANHA_THROW(value_error, "Invalid power algorithm");
+				}
+				powerAlgorithm = algorithm;
+			}
+
+
+			/// Thresholds driving the automatic selection of the multiplication algorithm.
+			/**
+			 * Sizes are expressed as the product of the number of terms of the two operands. The default values
+			 * are rules of thumb: they can be tuned for the host through piranha::calibrateMultiplication()
+			 * and stored into a profile file that later runs load.
+			 */
+			struct MultiplicationThresholds
+			{
+				MultiplicationThresholds() : plainCoded(1000), sparseDensity(1E-4), threadedCoded(400), threadedPlain(2500), fftCost(2) {}
+
+				/// Below this size plain multiplication is preferred over coded multiplication.
+				double plainCoded;
+				/// Below this density the coded representation is sparse, and it is multiplied through hashing.
+				double sparseDensity;
+				/// Above this size coded multiplication is split among threads.
+				double threadedCoded;
+				/// Above this size plain multiplication is split among threads.
+				double threadedPlain;
+				/// With the FFT algorithm, dense products of double precision coefficients go through the FFT above this size, in units of N log2(N), N being the transform length.
+				double fftCost;
+			};
+
+
+			/// Override of the multiplication thresholds for the scope of the object.
+			/**
+			 * The override is seen only by the multiplications launched from the thread that created the object,
+			 * hence it can be used to tune a single call without touching the global thresholds. The pool threads
+			 * working for those multiplications install the same thresholds for the duration of their jobs.
+			 */
+			class PIRANHA_VISIBLE MultiplicationThresholdsOverride
+			{
+				public:
+					explicit MultiplicationThresholdsOverride(const MultiplicationThresholds &);
+					~MultiplicationThresholdsOverride();
+
+					MultiplicationThresholdsOverride(const MultiplicationThresholdsOverride &) = delete;
+					MultiplicationThresholdsOverride &operator=(const MultiplicationThresholdsOverride &) = delete;
+
+				private:
+					const MultiplicationThresholds	m_thresholds;
+					const MultiplicationThresholds	*m_previous;
+			};
+
+
+			/// Thresholds in effect in the calling thread.
+			static const MultiplicationThresholds &getMultiplicationThresholds();
+			static void setMultiplicationThresholds(const MultiplicationThresholds &);
+			/// Load the multiplication thresholds from a profile file.
+			/**
+			 * The file contains one "key = value" line per threshold. Thresholds missing from the file are left untouched.
+			 */
+			static void loadMultiplicationProfile(const std::string &);
+			/// Save the multiplication thresholds into a profile file.
+			static void saveMultiplicationProfile(const std::string &);
+
+
 		private:
 
 			// Startup class.
@@ -152,7 +269,10 @@ namespace piranha
 			static const std::string	    m_version;
 			static startup_class		    startup;
 			static unsigned			        m_nthread;               // Number of threads available.
+			static std::size_t		        m_cache_sizes[cacheLevels]; // Data cache sizes in kilobytes, L1 first.
 			static MultiplicationAlgorithm	multiplicationAlgorithm;
+			static PowerAlgorithm			powerAlgorithm;
+			static MultiplicationThresholds	multiplicationThresholds;
 	};
 }
 
@@ -0,0 +1,376 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_SMALL_VECTOR_H
+#define PIRANHA_SMALL_VECTOR_H
+
+#include "config.h"
+#include "exceptions.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace piranha
+{
+	/// Vector storing up to N elements inline.
+	/**
+	 * A subset of the std::vector interface. As long as the size does not exceed N, the elements live inside the object itself
+	 * and no memory is allocated; beyond that they spill into heap memory obtained from Allocator. Shrinking never moves the elements
+	 * back inline. N = 0 gives a plain heap vector.
+	 *
+	 * Allocator must be stateless: it is default constructed whenever memory is allocated or released, so that it takes no space in the object.
+	 * Moving a vector whose elements are inline moves the elements one by one, hence moves are non-throwing only if the moves of T are.
+	 */
+	template <class T, std::size_t N, class Allocator = std::allocator<T> >
+	class SmallVector
+	{
+			typedef std::allocator_traits<typename std::allocator_traits<Allocator>::template rebind_alloc<T> > Traits;
+			typedef typename Traits::allocator_type AllocatorType;
+
+		public:
+
+			typedef T                 value_type;
+			typedef std::size_t       size_type;
+			typedef std::ptrdiff_t    difference_type;
+			typedef T                 &reference;
+			typedef T const           &const_reference;
+			typedef T                 *iterator;
+			typedef T const           *const_iterator;
+
+			/// Default ctor: empty vector, with inline storage.
+			SmallVector(): m_data(inlineData()), m_size(0), m_capacity(N) {}
+
+
+			/// Ctor with n value initialised elements.
+			explicit SmallVector(size_type const n): SmallVector()
+			{
+				resize(n);
+			}
+
+
+			/// Copy ctor.
+			SmallVector(SmallVector const &other): SmallVector()
+			{
+				reserve(other.m_size);
+				std::uninitialized_copy(other.begin(), other.end(), m_data);
+				m_size = other.m_size;
+			}
+
+
+			/// Move ctor. Heap storage is stolen, inline elements are moved. other is left empty.
+			SmallVector(SmallVector &&other) noexcept(std::is_nothrow_move_constructible<T>::value): SmallVector()
+			{
+				if (other.isInline())
+				{
+					std::uninitialized_move(other.begin(), other.end(), m_data);
+					m_size = other.m_size;
+					other.clear();
+				} else
+				{
+					m_data           = other.m_data;
+					m_size           = other.m_size;
+					m_capacity       = other.m_capacity;
+					other.m_data     = other.inlineData();
+					other.m_size     = 0;
+					other.m_capacity = N;
+				}
+			}
+
+
+			/// Dtor.
+			~SmallVector()
+			{
+				clear();
+				release();
+			}
+
+
+			/// Copy assignment. The existing storage is reused when large enough.
+			SmallVector &operator=(SmallVector const &other)
+			{
+				if (this == &other)
+				{
+					return *this;
+				}
+
+				if (other.m_size > m_capacity)
+				{
+					SmallVector tmp(other);
+					swap(tmp);
+					return *this;
+				}
+
+				const size_type common = std::min<size_type>(m_size, other.m_size);
+				std::copy(other.begin(), other.begin() + common, m_data);
+				if (other.m_size > m_size)
+				{
+					std::uninitialized_copy(other.begin() + common, other.end(), m_data + common);
+				} else
+				{
+					std::destroy(m_data + common, m_data + m_size);
+				}
+				m_size = other.m_size;
+				return *this;
+			}
+
+
+			/// Move assignment.
+			SmallVector &operator=(SmallVector &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+			{
+				if (this != &other)
+				{
+					clear();
+					if (other.isInline())
+					{
+						// Capacity is at least N, hence the elements fit.
+						std::uninitialized_move(other.begin(), other.end(), m_data);
+						m_size = other.m_size;
+						other.clear();
+					} else
+					{
+						release();
+						m_data           = other.m_data;
+						m_size           = other.m_size;
+						m_capacity       = other.m_capacity;
+						other.m_data     = other.inlineData();
+						other.m_size     = 0;
+						other.m_capacity = N;
+					}
+				}
+				return *this;
+			}
+
+
+			/// Swap content.
+			void swap(SmallVector &other)
+			{
+				if (!isInline() && !other.isInline())
+				{
+					std::swap(m_data, other.m_data);
+					std::swap(m_size, other.m_size);
+					std::swap(m_capacity, other.m_capacity);
+				} else
+				{
+					SmallVector tmp(std::move(other));
+					other = std::move(*this);
+					*this = std::move(tmp);
+				}
+			}
+
+
+			size_type size() const
+			{
+				return m_size;
+			}
+
+
+			bool empty() const
+			{
+				return m_size == 0;
+			}
+
+
+			size_type capacity() const
+			{
+				return m_capacity;
+			}
+
+
+			/// True if the elements are stored inside the object.
+			bool isInline() const
+			{
+				return m_data == inlineData();
+			}
+
+
+			T *data()
+			{
+				return m_data;
+			}
+
+
+			T const *data() const
+			{
+				return m_data;
+			}
+
+
+			iterator begin()
+			{
+				return m_data;
+			}
+
+
+			iterator end()
+			{
+				return m_data + m_size;
+			}
+
+
+			const_iterator begin() const
+			{
+				return m_data;
+			}
+
+
+			const_iterator end() const
+			{
+				return m_data + m_size;
+			}
+
+
+			T &operator[](size_type const n)
+			{
+				PIRANHA_ASSERT(n < m_size);
+				return m_data[n];
+			}
+
+
+			T const &operator[](size_type const n) const
+			{
+				PIRANHA_ASSERT(n < m_size);
+				return m_data[n];
+			}
+
+
+			/// Make room for n elements. Spills to the heap if n exceeds the inline capacity.
+			void reserve(size_type const n)
+			{
+				if (n <= m_capacity)
+				{
+					return;
+				}
+				PIRANHA_ASSERT(n <= UINT32_MAX);
+
+				AllocatorType allocator;
+				T *const newData = Traits::allocate(allocator, n);
+				try
+				{
+					std::uninitialized_copy(std::make_move_iterator(begin()), std::make_move_iterator(end()), newData);
+				}
+				catch (...)
+				{
+					Traits::deallocate(allocator, newData, n);
+					throw;
+				}
+				const size_type size = m_size;
+				clear();
+				release();
+				m_data     = newData;
+				m_size     = static_cast<std::uint32_t>(size);
+				m_capacity = static_cast<std::uint32_t>(n);
+			}
+
+
+			/// Resize to n elements. New elements are value initialised.
+			/**
+			 * Growing allocates exactly n elements, as keys are usually resized once to their final size.
+			 */
+			void resize(size_type const n)
+			{
+				if (n < m_size)
+				{
+					std::destroy(m_data + n, m_data + m_size);
+				} else if (n > m_size)
+				{
+					reserve(n);
+					std::uninitialized_value_construct(m_data + m_size, m_data + n);
+				}
+				m_size = static_cast<std::uint32_t>(n);
+			}
+
+
+			/// Append an element, growing the capacity geometrically.
+			void push_back(T const &value)
+			{
+				if (m_size == m_capacity)
+				{
+					// Copy first: value might be an element of this.
+					T tmp(value);
+					reserve(std::max<size_type>(2 * size_type(m_capacity), 4));
+					::new (static_cast<void *>(m_data + m_size)) T(std::move(tmp));
+				} else
+				{
+					::new (static_cast<void *>(m_data + m_size)) T(value);
+				}
+				++m_size;
+			}
+
+
+			/// Destroy all elements. The capacity is kept.
+			void clear()
+			{
+				std::destroy(begin(), end());
+				m_size = 0;
+			}
+
+
+			bool operator==(SmallVector const &other) const
+			{
+				return m_size == other.m_size && std::equal(begin(), end(), other.begin());
+			}
+
+
+			bool operator!=(SmallVector const &other) const
+			{
+				return !(*this == other);
+			}
+
+		private:
+
+			T *inlineData()
+			{
+				return reinterpret_cast<T *>(m_storage);
+			}
+
+
+			T const *inlineData() const
+			{
+				return reinterpret_cast<T const *>(m_storage);
+			}
+
+
+			// Give back the heap storage, if any. The elements must have been destroyed.
+			void release()
+			{
+				if (!isInline())
+				{
+					AllocatorType allocator;
+					Traits::deallocate(allocator, m_data, m_capacity);
+					m_data     = inlineData();
+					m_capacity = N;
+				}
+			}
+
+		private:
+
+			T             *m_data;
+			std::uint32_t  m_size;
+			std::uint32_t  m_capacity;
+			alignas(T) unsigned char m_storage[N > 0 ? N * sizeof(T) : 1];
+	};
+}
+
+#endif
@@ -0,0 +1,76 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_THREAD_POOL_H
+#define PIRANHA_THREAD_POOL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+#include "config.h"
+
+#pragma warning (push)
+#pragma warning (disable: 4251)
+
+namespace piranha
+{
+	/// Process-wide pool of worker threads.
+	/**
+	 * The pool is shared by all the multi-threaded multipliers, so that threads are not created and joined at every
+	 * multiplication. Its size follows settings::set_nthread(). Worker threads are started lazily, at the first
+	 * call to run().
+	 *
+	 * When run() is called from within a worker of the pool (e.g., when multiplying series coefficients inside a
+	 * multi-threaded multiplication), the jobs are executed serially in the calling thread, so that nested
+	 * parallelism cannot exhaust the pool and deadlock.
+	 */
+	class PIRANHA_VISIBLE ThreadPool
+	{
+		public:
+			typedef std::function<void()> Job;
+
+			/// Run the jobs on the pool and wait for their completion.
+			/**
+			 * All the jobs are run even if some of them throw. The first exception (in job order) is then
+			 * rethrown in the calling thread.
+			 */
+			static void run(std::vector<Job> const &jobs);
+			/// Number of worker threads.
+			static std::size_t size();
+			/// Change the number of worker threads.
+			/**
+			 * Must not be called while jobs are being run.
+			 */
+			static void resize(std::size_t n);
+			/// Whether the calling thread is a worker of the pool.
+			static bool inWorker();
+			/// Maximum number of queued jobs observed since the pool was (re)started.
+			static std::size_t maxQueueDepth();
+			/// Fraction of the workers' time spent running jobs since the pool was (re)started.
+			static double utilisation();
+			/// Write size, number of jobs, maximum queue depth and utilisation of the pool into piranha::stats.
+			static void traceStats();
+	};
+}
+
+#pragma warning (pop)
+
+#endif
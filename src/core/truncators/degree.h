@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <iostream>
 #include <iterator>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -119,7 +120,7 @@ namespace truncators {
 					typedef GetType type;
 
 					GetType(std::vector<TermType1 const *> &terms1, std::vector<TermType2 const *> &terms2, const ArgsTuple &argsTuple, bool initialise = true)
-                            :terms1(terms1), terms2(terms2), argsTuple(argsTuple)
+                            :terms1(terms1), terms2(terms2), argsTuple(argsTuple), integralLimit(0)
 					{
 						// Some static checks.
                         static_assert(Series1::exponentArgsPosition == Series2::exponentArgsPosition, "");
@@ -138,20 +139,45 @@ namespace truncators {
 					}
 
 
+					// t1 and t2 point into terms1 and terms2, whose (partial) degrees were computed by init().
 					bool skip(TermType1 const **t1, TermType2 const **t2) const
 					{
-						VectorPsym const symbols = argsTuple.get<exponentArgsPosition>(); //GUT temp test
+						PIRANHA_ASSERT(truncationMode != TRUNCATION_INACTIVE);
+						PIRANHA_ASSERT(t1 >= terms1.data() && t1 < terms1.data() + degrees1.size());
+						PIRANHA_ASSERT(t2 >= terms2.data() && t2 < terms2.data() + degrees2.size());
+
+						DegreeType const d1 = degrees1[t1 - terms1.data()];
+						DegreeType const d2 = degrees2[t2 - terms2.data()];
+						if constexpr (std::is_integral_v<DegreeType>)
+						{
+							return static_cast<long long>(d1) + static_cast<long long>(d2) >= integralLimit;
+						} else
+						{
+							return d1 + d2 >= degreeLimit;
+						}
+					}
+
+
+					// Minimum (partial) degree of a series, i.e., the degree the truncation limit is compared with.
+					template <class PowerSeries, class ArgsTuple2>
+					static mp_rational powerSeriesOrder(PowerSeries const &s, ArgsTuple2 const &argsTuple2)
+					{
+						// order will be either total or partial, depending on the mode.
+						mp_rational order(0);
+
 						switch (truncationMode)
                         {
-							case TRUNCATION_DEGREE:         return   ((*t1)->template get<exponentTermPosition>().order(symbols) + (*t2)->template get<exponentTermPosition>().order(symbols) >= degreeLimit);
+							case TRUNCATION_DEGREE:         order = s.order(argsTuple2.template get<exponentArgsPosition>()); // GUT: for truncation order on psym level
+								                            break;
 
-							case TRUNCATION_PARTIAL_DEGREE: return   ((*t1)->template get<exponentTermPosition>().partialOrder(positionTuple) 
-                                                                    + (*t2)->template get<exponentTermPosition>().partialOrder(positionTuple) >= degreeLimit);
+							case TRUNCATION_PARTIAL_DEGREE: order = s.basePartialOrder(psyms2pos(psyms, argsTuple2));
+								                            break;
 
-							case TRUNCATION_INACTIVE:       PIRANHA_ASSERT(false); // We should never get there.
-				 	    }
+							case TRUNCATION_INACTIVE:       PIRANHA_THROW(value_error, "Cannot calculate the order of a power series "
+								                                                       "if no degree limit has been set");
+						}
 
-						return false;
+						return order;
 					}
 
 
@@ -178,19 +204,7 @@ namespace truncators {
 								                       "an empty power series");
 						}
 
-						// order will be either total or partial, depending on the mode.
-						mp_rational order(0);
-
-						switch (truncationMode)
-                        {
-							case TRUNCATION_DEGREE:         order = s.order(argsTuple2.get<exponentArgsPosition>()); // GUT: for truncation order on psym level
-								                            break;
-
-							case TRUNCATION_PARTIAL_DEGREE: order = s.basePartialOrder(psyms2pos(psyms, argsTuple2));
-								                            break;
-
-							case TRUNCATION_INACTIVE:       PIRANHA_ASSERT(false);  // should not happen. An error
-						}
+						mp_rational const order(powerSeriesOrder(s, argsTuple2));
 
 						if (order <= 0) 
 						{
@@ -296,35 +310,79 @@ namespace truncators {
 
 				protected:
 
+					// Sort the terms by increasing (partial) degree, and store their degrees in the same order.
 					void init()
 					{
-						switch (truncationMode)
-                        {
-							//VectorPsym const & symbols = argsTuple2.get<Series::exponentArgsPosition>();
-
-							case TRUNCATION_DEGREE:         std::sort(terms1.begin(), terms1.end(), CompareOrder<exponentTermPosition>(argsTuple.get<exponentArgsPosition>()));
-								                            std::sort(terms2.begin(), terms2.end(), CompareOrder<exponentTermPosition>(argsTuple.get<exponentArgsPosition>()));
-								                            break;
+						if (!isEffective())
+						{
+							return;
+						}
 
-							case TRUNCATION_PARTIAL_DEGREE:	// We need to do the sorting only if the position tuple
-								                            // contains some elements.
-								                            if (positionTuple.template get<exponentArgsPosition>().size() > 0) 
-								                            {
-									                            std::sort(terms1.begin(), terms1.end(), ComparePartialOrder<exponentTermPosition, PosTupleType>(positionTuple));
-                                                                std::sort(terms2.begin(), terms2.end(), ComparePartialOrder<exponentTermPosition, PosTupleType>(positionTuple));
-								                            }
-								                            break;
-							case TRUNCATION_INACTIVE: ;   // nothing todo
+						sortByDegree(terms1, degrees1);
+						sortByDegree(terms2, degrees2);
 
+						if constexpr (std::is_integral_v<DegreeType>)
+						{
+							// Smallest integer not less than the limit, so that skip() works on integers only.
+							integralLimit = static_cast<long long>(std::ceil(degreeLimit.to_double()));
+							while (mp_rational(static_cast<int>(integralLimit)) < degreeLimit)
+							{
+								++integralLimit;
+							}
+							while (mp_rational(static_cast<int>(integralLimit - 1)) >= degreeLimit)
+							{
+								--integralLimit;
+							}
 						}
 					}
 
 				private:
 
+					typedef typename TermType1::template Component<exponentTermPosition>::Type::DegreeType DegreeType;
+
+
+					template <class Term>
+					DegreeType termDegree(Term const *term) const
+					{
+						if (truncationMode == TRUNCATION_PARTIAL_DEGREE)
+						{
+							return term->template get<exponentTermPosition>().partialOrder(positionTuple);
+						}
+
+						return term->template get<exponentTermPosition>().order(argsTuple.template get<exponentArgsPosition>());
+					}
+
+
+					// Each degree is computed once, rather than at every comparison.
+					template <class Term>
+					void sortByDegree(std::vector<Term const *> &terms, std::vector<DegreeType> &degrees) const
+					{
+						std::vector<std::pair<DegreeType, Term const *> > sorted;
+						sorted.reserve(terms.size());
+						for (std::size_t i = 0; i < terms.size(); ++i)
+						{
+							sorted.push_back(std::make_pair(termDegree(terms[i]), terms[i]));
+						}
+						std::sort(sorted.begin(), sorted.end(), [](std::pair<DegreeType, Term const *> const &p1, std::pair<DegreeType, Term const *> const &p2) { return p1.first < p2.first; });
+
+						degrees.resize(terms.size());
+						for (std::size_t i = 0; i < terms.size(); ++i)
+						{
+							degrees[i] = sorted[i].first;
+							terms[i]   = sorted[i].second;
+						}
+					}
+
+
 					std::vector<TermType1 const *>	&terms1;
 					std::vector<TermType2 const *>	&terms2;
 					const ArgsTuple			        &argsTuple;
 					PosTupleType			         positionTuple;
+					// (Partial) degrees of the terms, in the order of terms1 and terms2.
+					std::vector<DegreeType>			degrees1;
+					std::vector<DegreeType>			degrees2;
+					// Degree limit, rounded up, for integral degrees.
+					long long				        integralLimit;
 			};
 
 
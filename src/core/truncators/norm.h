@@ -26,6 +26,8 @@
 #include <cstddef>
 #include <iostream>
 #include <iterator>
+#include <numeric>
+#include <utility>
 #include <vector>
 
 #include <boost/lambda/lambda.hpp>
@@ -33,6 +35,7 @@
 
 #include "../config.h"
 #include "../exceptions.h"
+#include "../mp.h"
 #include "../settings.h"
 #include "../utils.h"
 
@@ -40,6 +43,11 @@ namespace piranha {
 namespace truncators {
 
 	/// Norm-based truncator.
+	/**
+	 * In the default mode the smallest terms of the two series are discarded as long as the norm of the neglected part
+	 * of the product stays below the truncation level. In the pairwise mode (see setPairwise()) each product of two terms
+	 * whose norm is below the truncation level is discarded.
+	 */
 	class PIRANHA_VISIBLE Norm
 	{
 			template <class ArgsTuple>
@@ -62,6 +70,13 @@ namespace truncators {
 
 
 		public:
+			enum TruncationMode
+			{
+				TRUNCATION_GLOBAL,
+				TRUNCATION_PAIRWISE
+			};
+
+
 			template <class Series1, class Series2, class ArgsTuple>
 			class GetType
 			{
@@ -80,8 +95,17 @@ namespace truncators {
 					}
 
 
+					// t1 and t2 point into terms1 and terms2, whose norms were computed by init().
 					bool skip(TermType1 const **t1, TermType2 const **t2) const
 					{
+						if (truncationMode == TRUNCATION_PAIRWISE)
+						{
+							PIRANHA_ASSERT(t1 >= terms1.data() && t1 < terms1.data() + norms1.size());
+							PIRANHA_ASSERT(t2 >= terms2.data() && t2 < terms2.data() + norms2.size());
+							// The terms are sorted by decreasing norm: along each row the skipped pairs come last.
+							return norms1[t1 - terms1.data()] * norms2[t2 - terms2.data()] < truncationLevel;
+						}
+
 						return (term1 && t1 >= term1) || (term2 && t2 >= term2);
 					}
 
@@ -134,6 +158,13 @@ namespace truncators {
 
 
 
+					template <class Series, class ArgsTuple2>
+					static mp_rational powerSeriesOrder(Series const &, ArgsTuple2 const &)
+					{
+						PIRANHA_THROW(value_error, "The norm truncator does not define the order of a power series");
+					}
+
+
                     // return a vector of pointers to the series terms sorted according to the norm
 					template <class Series, class ArgsTuple2>
 					static std::vector<typename Series::TermType const *> getSortedPointerVector(Series const &series, ArgsTuple2 const &argsTuple2)
@@ -163,15 +194,17 @@ namespace truncators {
 						if (isEffective()) 
 						{
 							PIRANHA_ASSERT(terms1.size() >= 1 && terms2.size() >= 1);
-							
-                            // we need it twice. Construct only once
-                            const CompareNorm<ArgsTuple> cmp(argsTuple);
 
-							std::sort(terms1.begin(), terms1.end(), cmp);
-							std::sort(terms2.begin(), terms2.end(), cmp);
+							sortByNorm(terms1, norms1);
+							sortByNorm(terms2, norms2);
 
-							const double norm1 = calculateNorm(terms1);
-                            const double norm2 = calculateNorm(terms2);
+							if (truncationMode == TRUNCATION_PAIRWISE)
+							{
+								return;
+							}
+
+							const double norm1 = std::accumulate(norms1.begin(), norms1.end(), 0.0);
+                            const double norm2 = std::accumulate(norms2.begin(), norms2.end(), 0.0);
 							// If one of the norms is zero, then we don't want to do any multiplication.
 							const TermType1 **final1 = &(*(terms1.begin()));
 							const TermType2 **final2 = &(*(terms2.begin()));
@@ -194,7 +227,7 @@ namespace truncators {
 							{
 								const TermType1 **tmp = (term1) ? term1 - 1 : &(*(terms1.end() - 1));
 
-								delta1 += (*tmp)->cf.norm(argsTuple) * (*tmp)->key.norm(argsTuple);
+								delta1 += norms1[tmp - terms1.data()];
 								
                                 // If, by going to the next term, we exceed the delta1, leave term1 where it is and break out.
 								if (delta1 >= limit1) 
@@ -215,7 +248,7 @@ namespace truncators {
 							{
 								const TermType2 **tmp = (term2) ? term2 - 1 : &(*(terms2.end() - 1));
 
-								delta2 += (*tmp)->cf.norm(argsTuple) * (*tmp)->key.norm(argsTuple);
+								delta2 += norms2[tmp - terms2.data()];
 								
                                 // If, by going to the next term, we exceed the delta2, leave term2 where it is and break out.
 								if (delta2 >= limit2) 
@@ -236,16 +269,25 @@ namespace truncators {
 
 				private:
 
+					// Sort the terms by decreasing norm, and store their norms in the same order. Each norm is computed once,
+					// rather than at every comparison.
 					template <class Term>
-					double calculateNorm(std::vector<Term const *> const &v) const
+					void sortByNorm(std::vector<Term const *> &terms, std::vector<double> &norms) const
 					{
-						double retval = 0;
-						std::size_t const end = v.size();
-						for (std::size_t i = 0; i < end; ++i) 
+						std::vector<std::pair<double, Term const *> > sorted;
+						sorted.reserve(terms.size());
+						for (std::size_t i = 0; i < terms.size(); ++i)
 						{
-							retval += v[i]->cf.norm(argsTuple) * v[i]->key.norm(argsTuple);
+							sorted.push_back(std::make_pair(terms[i]->cf.norm(argsTuple) * terms[i]->key.norm(argsTuple), terms[i]));
+						}
+						std::sort(sorted.begin(), sorted.end(), [](std::pair<double, Term const *> const &p1, std::pair<double, Term const *> const &p2) { return p1.first > p2.first; });
+
+						norms.resize(terms.size());
+						for (std::size_t i = 0; i < terms.size(); ++i)
+						{
+							norms[i] = sorted[i].first;
+							terms[i] = sorted[i].second;
 						}
-						return retval;
 					}
 
 					std::vector<TermType1 const *>	&terms1;
@@ -253,6 +295,9 @@ namespace truncators {
 					ArgsTuple const			        &argsTuple;
 					TermType1 const		            **term1;
 					TermType2 const		            **term2;
+					// Norms of the terms, in the order of terms1 and terms2.
+					std::vector<double>			    norms1;
+					std::vector<double>			    norms2;
 			};
 
 			// Shared portion.
@@ -264,6 +309,14 @@ namespace truncators {
 				}
 
 				truncationLevel = x;
+				truncationMode  = TRUNCATION_GLOBAL;
+			}
+
+			/// Discard the products of two terms whose norm is below x.
+			static void setPairwise(double const &x)
+			{
+				set(x);
+				truncationMode = TRUNCATION_PAIRWISE;
 			}
 
 			static void print(std::ostream &stream = std::cout);
@@ -271,7 +324,8 @@ namespace truncators {
 
 		private:
 
-			static double truncationLevel;
+			static double         truncationLevel;
+			static TruncationMode truncationMode;
 	};
 } }
 
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "../exceptions.h"
+#include "../mp.h"
 #include "degree.h"
 #include "norm.h"
 
@@ -108,6 +109,30 @@ namespace truncators
 					}
 
 
+					template <class Series, class ArgsTuple2>
+					static mp_rational powerSeriesOrder(const Series &series, const ArgsTuple2 &argsTuple2)
+					{
+						std::string msg("The power series truncator was not able to establish the order of a power series. The reported errors were:\n");
+						try {
+							return DegreeAncestor::powerSeriesOrder(series, argsTuple2);
+
+						} catch (const value_error &ve)
+                        {
+									msg += std::string(ve.what()) + "\n";
+						}
+
+						try {
+							return NormAncestor::powerSeriesOrder(series, argsTuple2);
+
+						} catch (const value_error &ve)
+                        {
+									msg += std::string(ve.what()) + "\n";
+						}
+
+						PIRANHA_THROW(value_error,msg);
+					}
+
+
 					template <class Series, class ArgsTuple2>
 					static std::vector<typename Series::TermType const *> getSortedPointerVector(const Series &series, const ArgsTuple2 &argsTuple2)
 					{
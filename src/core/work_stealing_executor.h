@@ -0,0 +1,249 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef PIRANHA_WORK_STEALING_EXECUTOR_H
+#define PIRANHA_WORK_STEALING_EXECUTOR_H
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "base_classes/base_counting_allocator.h"
+#include "config.h"
+#include "exceptions.h"
+#include "settings.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+namespace piranha
+{
+	/// Work-stealing executor for independent tasks.
+	/**
+	 * The tasks are split into contiguous chunks, one per thread. Each thread consumes its own chunk from the front
+	 * and, once it is exhausted, steals tasks from the back of the chunks of the other threads. Hence threads that
+	 * happen to receive lighter tasks do not sit idle while the others are still working.
+	 *
+	 * Tasks must be independent of each other: in the coded multipliers each task writes into its own region of
+	 * the output structure. Task is required to provide a void operator()().
+	 *
+	 * The time each thread spends running tasks (busy) and stealing or waiting for the other threads (idle) is measured,
+	 * and it can be reported through piranha::stats.
+	 */
+	class WorkStealingExecutor
+	{
+			// Chunk of tasks of one thread, [first, last[. The owner takes from the front, thieves from the back.
+			struct Chunk
+			{
+				Chunk() : first(0), last(0) {}
+
+				boost::mutex	mutex;
+				std::size_t		first;
+				std::size_t		last;
+			};
+
+
+			template <class Task>
+			struct Worker
+			{
+				// The thresholds in effect are captured in the launching thread, since an override is not seen by the pool threads.
+				Worker(WorkStealingExecutor &executor, std::vector<Task> &tasks, std::size_t const threadId)
+                    : executor(executor), tasks(tasks), threadId(threadId), thresholds(settings::getMultiplicationThresholds())
+				{}
+
+
+				void operator()()
+				{
+					const settings::MultiplicationThresholdsOverride thresholdsOverride(thresholds);
+					std::size_t n;
+					while (!executor.m_abort && (executor.pop(threadId, n) || executor.steal(threadId, n)))
+					{
+						const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+						try
+						{
+							tasks[n]();
+						} catch (...)
+						{
+							executor.m_errors[threadId] = std::current_exception();
+							executor.m_abort = true;
+						}
+						executor.m_busy[threadId] += (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds();
+					}
+					// Pool threads outlive the run: count their memory now.
+					ThreadMemoryCounter::flush();
+				}
+
+
+				WorkStealingExecutor						&executor;
+				std::vector<Task>							&tasks;
+				const std::size_t							threadId;
+				const settings::MultiplicationThresholds	thresholds;
+			};
+
+		public:
+
+			/// Constructor from number of threads.
+			explicit WorkStealingExecutor(std::size_t const nthread)
+                : m_chunks(nthread), m_busy(nthread, 0), m_idle(nthread, 0), m_errors(nthread), m_abort(false), m_tasks(0)
+			{
+				if (nthread == 0)
+				{
+					PIRANHA_THROW(value_error, "the number of threads must be strictly positive");
+				}
+			}
+
+
+			/// Run the tasks and wait for their completion.
+			/**
+			 * If any task throws, the remaining tasks are abandoned and the first exception is rethrown
+			 * in the calling thread.
+			 */
+			template <class Task>
+			void run(std::vector<Task> &tasks)
+			{
+				const std::size_t nthread = m_chunks.size();
+				// Assign contiguous chunks, so that neighbouring tasks stay on the same thread.
+				for (std::size_t i = 0; i < nthread; ++i)
+				{
+					m_chunks[i].first = (i * tasks.size()) / nthread;
+					m_chunks[i].last  = ((i + 1) * tasks.size()) / nthread;
+					m_busy[i]   = 0;
+					m_errors[i] = std::exception_ptr();
+				}
+				m_abort = false;
+				m_tasks = tasks.size();
+
+				const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+				if (nthread == 1)
+				{
+					Worker<Task> w(*this, tasks, 0);
+					w();
+				} else
+				{
+					std::vector<ThreadPool::Job> jobs;
+					for (std::size_t i = 0; i < nthread; ++i)
+					{
+						jobs.push_back(Worker<Task>(*this, tasks, i));
+					}
+					ThreadPool::run(jobs);
+				}
+				const long long wall = (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds();
+
+				for (std::size_t i = 0; i < nthread; ++i)
+				{
+					m_idle[i] = (wall > m_busy[i]) ? wall - m_busy[i] : 0;
+				}
+
+				for (std::size_t i = 0; i < nthread; ++i)
+				{
+					if (m_errors[i])
+					{
+						std::rethrow_exception(m_errors[i]);
+					}
+				}
+			}
+
+
+			/// Accumulate per-thread busy and idle times of the last run into piranha::stats, in microseconds.
+			/**
+			 * The number of tasks of the last run is accumulated as well, and the statistics of the thread pool are updated.
+			 * Must be called from the thread that launched the tasks, since piranha::stats is not thread-safe.
+			 */
+			void traceStats(std::string const &prefix) const
+			{
+				for (std::size_t i = 0; i < m_busy.size(); ++i)
+				{
+					const std::string thread = prefix + " thread " + boost::lexical_cast<std::string>(i);
+					const std::size_t busy = static_cast<std::size_t>(m_busy[i]);
+					const std::size_t idle = static_cast<std::size_t>(m_idle[i]);
+					stats::trace_stat(thread + " busy (us)", std::size_t(0), [busy](const std::size_t x) -> std::size_t { return x + busy; });
+					stats::trace_stat(thread + " idle (us)", std::size_t(0), [idle](const std::size_t x) -> std::size_t { return x + idle; });
+				}
+				const std::size_t tasks = m_tasks;
+				stats::trace_stat(prefix + " tasks", std::size_t(0), [tasks](const std::size_t x) -> std::size_t { return x + tasks; });
+				ThreadPool::traceStats();
+			}
+
+
+			/// Busy time of a thread during the last run, in microseconds.
+			long long busy(std::size_t const threadId) const
+			{
+				PIRANHA_ASSERT(threadId < m_busy.size());
+				return m_busy[threadId];
+			}
+
+
+			/// Idle time of a thread during the last run, in microseconds.
+			long long idle(std::size_t const threadId) const
+			{
+				PIRANHA_ASSERT(threadId < m_idle.size());
+				return m_idle[threadId];
+			}
+
+		private:
+
+			// Take the next task from the front of the thread's own chunk.
+			bool pop(std::size_t const threadId, std::size_t &n)
+			{
+				Chunk &chunk = m_chunks[threadId];
+				boost::lock_guard<boost::mutex> lock(chunk.mutex);
+				if (chunk.first == chunk.last)
+				{
+					return false;
+				}
+				n = chunk.first++;
+				return true;
+			}
+
+
+			// Take a task from the back of the chunk of another thread.
+			bool steal(std::size_t const threadId, std::size_t &n)
+			{
+				const std::size_t nthread = m_chunks.size();
+				for (std::size_t k = 1; k < nthread; ++k)
+				{
+					Chunk &chunk = m_chunks[(threadId + k) % nthread];
+					boost::lock_guard<boost::mutex> lock(chunk.mutex);
+					if (chunk.first != chunk.last)
+					{
+						n = --chunk.last;
+						return true;
+					}
+				}
+				return false;
+			}
+
+
+			std::vector<Chunk>				m_chunks;
+			std::vector<long long>			m_busy;
+			std::vector<long long>			m_idle;
+			std::vector<std::exception_ptr>	m_errors;
+			std::atomic<bool>				m_abort;
+			std::size_t						m_tasks;
+	};
+}
+
+#endif
@@ -37,7 +37,7 @@ namespace manipulators
 	typedef FourierSeries
 	<
 		double_cf,
-		TrigVector<int16_t, 0>,
+		TrigVector<int16_t, 0, 8>,
 		PoissonSeriesMultiplier,
 		truncators::Norm
 	> dfs;
@@ -37,7 +37,7 @@ namespace manipulators
 	typedef Polynomial
 	<
 		double_cf,
-		ExpoVector<int16_t, 0>,
+		ExpoVector<int16_t, 0, 8>,
 		polynomial_multiplier,
 		truncators::PowerSeries
 	> dpoly;
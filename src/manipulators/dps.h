@@ -38,8 +38,8 @@ namespace manipulators {
 	typedef poisson_series
 	<
 		double_cf,
-		ExpoVector<int16_t, 0>,
-		TrigVector<int16_t, 1>,
+		ExpoVector<int16_t, 0, 8>,
+		TrigVector<int16_t, 1, 8>,
 		polynomial_multiplier,
 		PoissonSeriesMultiplier,
 		truncators::PowerSeries,
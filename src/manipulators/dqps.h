@@ -40,7 +40,7 @@ namespace manipulators
 	<
 		double_cf,
 		ExpoVector<mp_rational,0>,
-		TrigVector<int16_t, 1>,
+		TrigVector<int16_t, 1, 8>,
 		polynomial_multiplier,
 		PoissonSeriesMultiplier,
 		truncators::PowerSeries,
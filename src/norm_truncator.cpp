@@ -34,14 +34,16 @@ namespace piranha
     // allocation for static member and
 	// and initial value for norm-based truncation.
     //
-	double Norm::truncationLevel = 0.0;
+	double               Norm::truncationLevel = 0.0;
+	Norm::TruncationMode Norm::truncationMode  = Norm::TRUNCATION_GLOBAL;
 
     // print the current status of the norm truncator
 	void Norm::print(std::ostream &stream)
 	{
 		if (truncationLevel > 0)
          {
-			stream << "Truncation level: " << boost::lexical_cast<std::string>(truncationLevel);
+			stream << ((truncationMode == TRUNCATION_PAIRWISE) ? "Pairwise truncation level: " : "Truncation level: ")
+			       << boost::lexical_cast<std::string>(truncationLevel);
 		} else
         {
 			stream << "No truncation level set.";
@@ -52,5 +54,6 @@ namespace piranha
 	void Norm::unset()
 	{
 		truncationLevel = 0.0;
+		truncationMode  = TRUNCATION_GLOBAL;
 	}
 }
@@ -36,4 +36,6 @@ namespace piranha
 #include "manipulators/zpoly.h"
 #include "manipulators/dfs.h"
 
+#include "core/multiplication_calibration.h"
+
 #endif
@@ -18,15 +18,34 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <climits>
 #include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
 #include <thread>
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <vector>
+#endif
+
 #include "core/config.h"
 #include "core/exceptions.h"
 #include "core/memory.h"
 #include "core/settings.h"
+#include "core/thread_pool.h"
 
 /////////////////////////////////////////////////////////////////////////////////////
 //
@@ -37,6 +56,90 @@
 
 namespace piranha
 {
+        namespace
+        {
+                // Per-thread override of the multiplication thresholds, if any.
+                thread_local const settings::MultiplicationThresholds *thresholdsOverride = 0;
+
+                // Profile keys, in the order they are saved.
+                const char *const thresholdKeys[] = {"plain_coded", "sparse_density", "threaded_coded", "threaded_plain", "fft_cost"};
+
+                double &thresholdByKey(settings::MultiplicationThresholds &t, const std::string &key)
+                {
+                        if (key == thresholdKeys[0]) {
+                                return t.plainCoded;
+                        } else if (key == thresholdKeys[1]) {
+                                return t.sparseDensity;
+                        } else if (key == thresholdKeys[2]) {
+                                return t.threadedCoded;
+                        } else if (key == thresholdKeys[3]) {
+                                return t.threadedPlain;
+                        } else if (key == thresholdKeys[4]) {
+                                return t.fftCost;
+                        }
+                        PIRANHA_THROW(value_error, "unknown multiplication threshold '" + key + "'");
+                }
+
+                // Detect the data cache sizes in kilobytes, L1 first. Undetected levels are left to zero.
+                void detectCaches(std::size_t (&sizes)[settings::cacheLevels])
+                {
+                        for (unsigned i = 0; i < settings::cacheLevels; ++i) {
+                                sizes[i] = 0;
+                        }
+#if defined(_WIN32)
+                        DWORD length = 0;
+                        GetLogicalProcessorInformation(0, &length);
+                        if (length == 0) {
+                                return;
+                        }
+                        std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> info(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+                        if (!GetLogicalProcessorInformation(&info[0], &length)) {
+                                return;
+                        }
+                        for (std::size_t i = 0; i < info.size(); ++i) {
+                                const CACHE_DESCRIPTOR &cache = info[i].Cache;
+                                if (info[i].Relationship == RelationCache && cache.Type != CacheInstruction &&
+                                        cache.Level >= 1 && cache.Level <= settings::cacheLevels) {
+                                        sizes[cache.Level - 1] = cache.Size / 1024;
+                                }
+                        }
+#elif defined(__linux__)
+                        // One directory per cache of the first CPU, e.g. /sys/devices/system/cpu/cpu0/cache/index2.
+                        const std::string base("/sys/devices/system/cpu/cpu0/cache/index");
+                        for (unsigned index = 0; ; ++index) {
+                                const std::string dir = base + boost::lexical_cast<std::string>(index) + "/";
+                                std::ifstream levelFile((dir + "level").c_str()), typeFile((dir + "type").c_str()), sizeFile((dir + "size").c_str());
+                                unsigned level = 0;
+                                std::string type, size;
+                                if (!(levelFile >> level) || !(typeFile >> type) || !(sizeFile >> size)) {
+                                        break;
+                                }
+                                if (type == "Instruction" || level < 1 || level > settings::cacheLevels || size.empty()) {
+                                        continue;
+                                }
+                                // Sizes are written as, e.g., "48K" or "32M".
+                                std::size_t multiplier = 1;
+                                switch (size[size.size() - 1]) {
+                                        case 'K':
+                                                size.erase(size.size() - 1);
+                                                break;
+                                        case 'M':
+                                                multiplier = 1024;
+                                                size.erase(size.size() - 1);
+                                                break;
+                                        case 'G':
+                                                multiplier = 1024 * 1024;
+                                                size.erase(size.size() - 1);
+                                                break;
+                                }
+                                try {
+                                        sizes[level - 1] = boost::lexical_cast<std::size_t>(size) * multiplier;
+                                } catch (const boost::bad_lexical_cast &) {}
+                        }
+#endif
+                }
+        }
+
         // Settings' static members.
         std::size_t settings::m_memory_limit = 15500000000u; // ~ 15.5GByte
         double settings::m_numerical_zero = 1E-80;
@@ -45,9 +148,12 @@ namespace piranha
         const std::size_t settings::cache_size = PIRANHA_CACHE_SIZE;
         bool settings::blocker = false;
         unsigned settings::m_nthread = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+        settings::MultiplicationThresholds settings::multiplicationThresholds;
+        std::size_t settings::m_cache_sizes[settings::cacheLevels] = {32, PIRANHA_CACHE_SIZE, PIRANHA_CACHE_SIZE};
         settings::startup_class settings::startup;
         std::size_t settings::m_max_pretty_print_size = 500;
         settings::MultiplicationAlgorithm settings::multiplicationAlgorithm = settings::MultiplicationAlgorithm::AUTOMATIC;
+        settings::PowerAlgorithm settings::powerAlgorithm = settings::PowerAlgorithm::AUTOMATIC;
 
         settings::startup_class::startup_class()
         {
@@ -60,11 +166,22 @@ namespace piranha
                 static_assert(sizeof(std::size_t) == sizeof(void *), "std::size_t and void * are not the same size.");
                 static_assert(PIRANHA_MAX_ECHELON_LEVEL >= 0, "Max echelon level must be nonnegative.");
                 static_assert(settings::cache_size > 0 && lg<settings::cache_size>::value > 1, "Invalid value for cache size.");
+                settings::detect_cache_sizes();
+                // Thresholds tuned by a previous calibration.
+                if (const char *profile = std::getenv("PIRANHA_MULTIPLICATION_PROFILE")) {
+                        try {
+                                settings::loadMultiplicationProfile(profile);
+                        } catch (const std::exception &e) {
+                                std::cout << "Unable to load the multiplication profile: " << e.what() << std::endl;
+                        }
+                }
                 // Startup report.
                 std::cout << "Piranha version         : " << "@PIRANHA_VERSION_STRING@" << std::endl;
                 std::cout << "Piranha GIT revision    : " << "@PIRANHA_GIT_REVISION@" << std::endl;
                 std::cout << "Number of cores detected: " <<
                         (std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1) << std::endl;
+                std::cout << "Cache sizes (L1/L2/L3)  : " << settings::get_cache_size(1) << "K/" << settings::get_cache_size(2) << "K/" <<
+                        settings::get_cache_size(3) << "K" << std::endl;
                 std::cout << std::endl << std::endl << 
                                                          "--------------------------" << std::endl <<
                                                          "! Piranha core is ready. ! " << std::endl;
@@ -93,6 +210,11 @@ namespace piranha
 
         void settings::set_nthread(const unsigned int &n)
         {
+                if (n == 0)
+                {
+                        PIRANHA_THROW(value_error,"the number of threads must be strictly positive");
+                }
+                ThreadPool::resize(n);
                 m_nthread = n;
         }
 
@@ -100,4 +222,100 @@ namespace piranha
         {
                 return m_nthread;
         }
+
+        std::size_t settings::get_cache_size(const unsigned &level)
+        {
+                if (level < 1 || level > cacheLevels) {
+                        PIRANHA_THROW(value_error, "invalid cache level");
+                }
+                return m_cache_sizes[level - 1];
+        }
+
+        void settings::set_cache_size(const unsigned &level, const std::size_t &size)
+        {
+                if (level < 1 || level > cacheLevels) {
+                        PIRANHA_THROW(value_error, "invalid cache level");
+                }
+                if (size == 0) {
+                        PIRANHA_THROW(value_error, "the cache size must be strictly positive");
+                }
+                m_cache_sizes[level - 1] = size;
+        }
+
+        void settings::detect_cache_sizes()
+        {
+                std::size_t detected[cacheLevels];
+                detectCaches(detected);
+                const std::size_t fallback[cacheLevels] = {32, cache_size, cache_size};
+                for (unsigned i = 0; i < cacheLevels; ++i) {
+                        m_cache_sizes[i] = detected[i] ? detected[i] : fallback[i];
+                }
+        }
+
+        settings::MultiplicationThresholdsOverride::MultiplicationThresholdsOverride(const MultiplicationThresholds &t):
+                m_thresholds(t), m_previous(thresholdsOverride)
+        {
+                thresholdsOverride = &m_thresholds;
+        }
+
+        settings::MultiplicationThresholdsOverride::~MultiplicationThresholdsOverride()
+        {
+                thresholdsOverride = m_previous;
+        }
+
+        const settings::MultiplicationThresholds &settings::getMultiplicationThresholds()
+        {
+                return thresholdsOverride ? *thresholdsOverride : multiplicationThresholds;
+        }
+
+        void settings::setMultiplicationThresholds(const MultiplicationThresholds &t)
+        {
+                if (!(t.plainCoded >= 0 && t.threadedCoded >= 0 && t.threadedPlain >= 0 && t.fftCost >= 0)) {
+                        PIRANHA_THROW(value_error, "multiplication size thresholds must be non-negative");
+                }
+                if (!(t.sparseDensity > 0 && t.sparseDensity <= 1)) {
+                        PIRANHA_THROW(value_error, "the sparse density threshold must be in the ]0,1] interval");
+                }
+                multiplicationThresholds = t;
+        }
+
+        void settings::loadMultiplicationProfile(const std::string &fileName)
+        {
+                std::ifstream in(fileName.c_str());
+                if (!in) {
+                        PIRANHA_THROW(value_error, "unable to open the multiplication profile " + fileName);
+                }
+                MultiplicationThresholds t(multiplicationThresholds);
+                std::string line;
+                while (std::getline(in, line)) {
+                        boost::trim(line);
+                        if (line.empty() || line[0] == '#') {
+                                continue;
+                        }
+                        const std::string::size_type eq = line.find('=');
+                        if (eq == std::string::npos) {
+                                PIRANHA_THROW(value_error, "invalid line in the multiplication profile: " + line);
+                        }
+                        const std::string key = boost::trim_copy(line.substr(0, eq));
+                        try {
+                                thresholdByKey(t, key) = boost::lexical_cast<double>(boost::trim_copy(line.substr(eq + 1)));
+                        } catch (const boost::bad_lexical_cast &) {
+                                PIRANHA_THROW(value_error, "invalid value in the multiplication profile: " + line);
+                        }
+                }
+                setMultiplicationThresholds(t);
+        }
+
+        void settings::saveMultiplicationProfile(const std::string &fileName)
+        {
+                std::ofstream out(fileName.c_str());
+                if (!out) {
+                        PIRANHA_THROW(value_error, "unable to write the multiplication profile " + fileName);
+                }
+                out.precision(std::numeric_limits<double>::digits10 + 2);
+                out << "# Piranha multiplication profile" << std::endl;
+                for (const char *key: thresholdKeys) {
+                        out << key << " = " << thresholdByKey(multiplicationThresholds, key) << std::endl;
+                }
+        }
 }
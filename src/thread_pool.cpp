@@ -0,0 +1,347 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "core/exceptions.h"
+#include "core/settings.h"
+#include "core/stats.h"
+#include "core/thread_pool.h"
+
+namespace piranha
+{
+	namespace
+	{
+		// Jobs submitted by one call to ThreadPool::run().
+		struct Batch
+		{
+			explicit Batch(std::size_t n) : remaining(n), errors(n) {}
+
+			boost::mutex					mutex;
+			boost::condition_variable		done;
+			std::size_t						remaining;
+			std::vector<std::exception_ptr>	errors;
+		};
+
+
+		struct Entry
+		{
+			ThreadPool::Job const	*job;
+			Batch					*batch;
+			std::size_t				index;
+		};
+
+
+		thread_local bool isWorker = false;
+
+
+		class Pool
+		{
+			public:
+
+				Pool() : m_size(0), m_stop(false), m_jobs(0), m_maxQueueDepth(0), m_busy(0) {}
+
+
+				void run(std::vector<ThreadPool::Job> const &jobs)
+				{
+					Batch batch(jobs.size());
+					{
+						boost::lock_guard<boost::mutex> lock(m_mutex);
+						start();
+						for (std::size_t i = 0; i < jobs.size(); ++i)
+						{
+							const Entry entry = {&jobs[i], &batch, i};
+							m_queue.push_back(entry);
+						}
+						m_jobs += jobs.size();
+						if (m_queue.size() > m_maxQueueDepth)
+						{
+							m_maxQueueDepth = m_queue.size();
+						}
+					}
+					m_wakeup.notify_all();
+
+					{
+						boost::unique_lock<boost::mutex> lock(batch.mutex);
+						while (batch.remaining)
+						{
+							batch.done.wait(lock);
+						}
+					}
+
+					for (std::size_t i = 0; i < batch.errors.size(); ++i)
+					{
+						if (batch.errors[i])
+						{
+							std::rethrow_exception(batch.errors[i]);
+						}
+					}
+				}
+
+
+				std::size_t size()
+				{
+					boost::lock_guard<boost::mutex> lock(m_mutex);
+					return m_size ? m_size : settings::get_nthread();
+				}
+
+
+				void resize(std::size_t const n)
+				{
+					if (n == 0)
+					{
+						PIRANHA_THROW(value_error, "the number of threads in the pool must be strictly positive");
+					}
+					{
+						// settings::set_nthread() calls this at every change of setting: keep the workers if the size stays the same.
+						boost::lock_guard<boost::mutex> lock(m_mutex);
+						if (n == m_size)
+						{
+							return;
+						}
+					}
+					stop();
+					boost::lock_guard<boost::mutex> lock(m_mutex);
+					m_size = n;
+				}
+
+
+				std::size_t maxQueueDepth()
+				{
+					boost::lock_guard<boost::mutex> lock(m_mutex);
+					return m_maxQueueDepth;
+				}
+
+
+				std::size_t jobs()
+				{
+					boost::lock_guard<boost::mutex> lock(m_mutex);
+					return m_jobs;
+				}
+
+
+				double utilisation()
+				{
+					boost::lock_guard<boost::mutex> lock(m_mutex);
+					if (m_workers.empty())
+					{
+						return 0.;
+					}
+					const double elapsed = static_cast<double>((boost::posix_time::microsec_clock::universal_time() - m_startTime).total_microseconds());
+					if (elapsed <= 0)
+					{
+						return 0.;
+					}
+					return static_cast<double>(m_busy) / (elapsed * static_cast<double>(m_workers.size()));
+				}
+
+			private:
+
+				// Start the workers, if needed. Must be called with the mutex locked.
+				void start()
+				{
+					if (!m_workers.empty())
+					{
+						return;
+					}
+					if (!m_size)
+					{
+						m_size = settings::get_nthread();
+					}
+					m_stop          = false;
+					m_jobs          = 0;
+					m_maxQueueDepth = 0;
+					m_busy          = 0;
+					m_startTime     = boost::posix_time::microsec_clock::universal_time();
+					for (std::size_t i = 0; i < m_size; ++i)
+					{
+						m_workers.push_back(new boost::thread(&Pool::work, this));
+					}
+				}
+
+
+				// Let the workers drain the queue, then join them.
+				void stop()
+				{
+					std::vector<boost::thread *> workers;
+					{
+						boost::lock_guard<boost::mutex> lock(m_mutex);
+						m_stop = true;
+						workers.swap(m_workers);
+					}
+					m_wakeup.notify_all();
+					for (std::size_t i = 0; i < workers.size(); ++i)
+					{
+						workers[i]->join();
+						delete workers[i];
+					}
+				}
+
+
+				void work()
+				{
+					isWorker = true;
+					while (true)
+					{
+						Entry entry;
+						{
+							boost::unique_lock<boost::mutex> lock(m_mutex);
+							while (!m_stop && m_queue.empty())
+							{
+								m_wakeup.wait(lock);
+							}
+							if (m_queue.empty())
+							{
+								return;
+							}
+							entry = m_queue.front();
+							m_queue.pop_front();
+						}
+
+						const boost::posix_time::ptime t0 = boost::posix_time::microsec_clock::universal_time();
+						try
+						{
+							(*entry.job)();
+						} catch (...)
+						{
+							entry.batch->errors[entry.index] = std::current_exception();
+						}
+						m_busy += (boost::posix_time::microsec_clock::universal_time() - t0).total_microseconds();
+
+						boost::lock_guard<boost::mutex> lock(entry.batch->mutex);
+						if (--entry.batch->remaining == 0)
+						{
+							entry.batch->done.notify_all();
+						}
+					}
+				}
+
+
+				boost::mutex					m_mutex;
+				boost::condition_variable		m_wakeup;
+				std::deque<Entry>				m_queue;
+				std::vector<boost::thread *>	m_workers;
+				// Requested number of workers, 0 means settings::get_nthread().
+				std::size_t						m_size;
+				bool							m_stop;
+				std::size_t						m_jobs;
+				std::size_t						m_maxQueueDepth;
+				std::atomic<long long>			m_busy;
+				boost::posix_time::ptime		m_startTime;
+		};
+
+
+		// NOTE: the pool is never destroyed, since joining threads during the destruction of static
+		//       objects (i.e., while the library is being unloaded) is not safe on all platforms.
+		Pool &pool()
+		{
+			static Pool *p = new Pool();
+			return *p;
+		}
+	}
+
+
+	void ThreadPool::run(std::vector<Job> const &jobs)
+	{
+		if (jobs.empty())
+		{
+			return;
+		}
+		// Nested or trivial parallelism: just run the jobs here.
+		if (isWorker || jobs.size() == 1)
+		{
+			std::exception_ptr error;
+			for (std::size_t i = 0; i < jobs.size(); ++i)
+			{
+				try
+				{
+					jobs[i]();
+				} catch (...)
+				{
+					if (!error)
+					{
+						error = std::current_exception();
+					}
+				}
+			}
+			if (error)
+			{
+				std::rethrow_exception(error);
+			}
+			return;
+		}
+		pool().run(jobs);
+	}
+
+
+	std::size_t ThreadPool::size()
+	{
+		return pool().size();
+	}
+
+
+	void ThreadPool::resize(std::size_t n)
+	{
+		if (isWorker)
+		{
+			PIRANHA_THROW(value_error, "the thread pool cannot be resized from one of its workers");
+		}
+		pool().resize(n);
+	}
+
+
+	bool ThreadPool::inWorker()
+	{
+		return isWorker;
+	}
+
+
+	std::size_t ThreadPool::maxQueueDepth()
+	{
+		return pool().maxQueueDepth();
+	}
+
+
+	double ThreadPool::utilisation()
+	{
+		return pool().utilisation();
+	}
+
+
+	void ThreadPool::traceStats()
+	{
+		stats::set("thread_pool: size", boost::lexical_cast<std::string>(pool().size()));
+		stats::set("thread_pool: jobs", boost::lexical_cast<std::string>(pool().jobs()));
+		stats::set("thread_pool: max queue depth", boost::lexical_cast<std::string>(pool().maxQueueDepth()));
+		stats::set("thread_pool: utilisation", boost::lexical_cast<std::string>(pool().utilisation()));
+	}
+}
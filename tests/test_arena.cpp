@@ -0,0 +1,61 @@
+#define BOOST_TEST_MODULE Arena Test
+#include "boost/test/included/unit_test.hpp"
+
+#include "piranha.h"
+
+#include <cstdint>
+#include <vector>
+
+using namespace piranha;
+
+
+BOOST_AUTO_TEST_CASE(arena_allocator)
+{
+	std::size_t const before = settings::get_used_memory();
+	{
+		// Small chunks, so that both shared and dedicated chunks are exercised.
+		Arena arena(4096);
+		std::vector<int, ArenaAllocator<int> > v{ArenaAllocator<int>(arena)};
+		for (int i = 0; i < 100000; ++i)
+		{
+			v.push_back(i);
+		}
+		BOOST_TEST(v[99999] == 99999);
+		BOOST_TEST(arena.size() > 0u);
+		BOOST_TEST(settings::get_used_memory() >= before + arena.size());
+	}
+	// The chunks are accounted for, and given back in one step.
+	BOOST_TEST(settings::get_used_memory() == before);
+}
+
+
+BOOST_AUTO_TEST_CASE(arena_alignment)
+{
+	// The chunk size is not a multiple of the alignment: aligning may move past the end of a chunk.
+	Arena arena(100);
+	for (int i = 0; i < 100; ++i)
+	{
+		char *const p = static_cast<char *>(arena.allocate(1 + i % 7, 1));
+		char *const q = static_cast<char *>(arena.allocate(8, 64));
+		BOOST_TEST(reinterpret_cast<std::uintptr_t>(q) % 64 == 0u);
+		BOOST_TEST((q >= p + 1 + i % 7 || q + 8 <= p));
+	}
+
+	// Only the most recent allocation is given back.
+	void *const p = arena.allocate(16, 8);
+	arena.deallocate(p, 16);
+	BOOST_TEST(arena.allocate(16, 8) == p);
+}
+
+
+BOOST_AUTO_TEST_CASE(arena_default_allocator)
+{
+	// Without an arena the allocator falls back to CountingAllocator.
+	ArenaAllocator<int> allocator;
+	int *const p = allocator.allocate(10);
+	p[9] = 9;
+	allocator.deallocate(p, 10);
+	BOOST_TEST((allocator == ArenaAllocator<double>()));
+	Arena arena;
+	BOOST_TEST((allocator != ArenaAllocator<int>(arena)));
+}
@@ -0,0 +1,857 @@
+#define BOOST_TEST_MODULE Coded multiplication Test
+#include "boost/test/included/unit_test.hpp"
+
+// Tests for the coded multipliers: whatever the algorithm and the number of threads, the result must be
+// the same as the one of plain multiplication, and products with known coefficients are checked term by term.
+
+#include "piranha.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <set>
+#include <thread>
+
+using namespace piranha;
+using namespace piranha::manipulators;
+
+namespace {
+
+	typedef settings::MultiplicationAlgorithm Algorithm;
+
+	// Restore the global settings at the end of each test.
+	struct SettingsGuard
+	{
+		SettingsGuard() : nthread(settings::get_nthread()), algorithm(settings::getMultiplicationAlgorithm()),
+			thresholds(settings::getMultiplicationThresholds()), powerAlgorithm(settings::getPowerAlgorithm()) {}
+
+		~SettingsGuard()
+		{
+			settings::set_nthread(static_cast<unsigned>(nthread));
+			settings::setMultiplicationAlgorithm(algorithm);
+			settings::setMultiplicationThresholds(thresholds);
+			settings::setPowerAlgorithm(powerAlgorithm);
+		}
+
+		std::size_t                         nthread;
+		Algorithm                           algorithm;
+		settings::MultiplicationThresholds  thresholds;
+		settings::PowerAlgorithm            powerAlgorithm;
+	};
+
+	// Number of multiplications of a kind traced so far.
+	std::size_t statCount(std::string const &key)
+	{
+		try
+		{
+			return boost::lexical_cast<std::size_t>(stats::get(key));
+		} catch (value_error const &)
+		{
+			return 0;
+		}
+	}
+
+	// Task recording the thresholds seen by the thread running it.
+	struct ThresholdsTask
+	{
+		void operator()()
+		{
+			plainCoded = settings::getMultiplicationThresholds().plainCoded;
+		}
+
+		double plainCoded;
+	};
+
+	// Task recording the thread running it, after sleeping for the given number of milliseconds.
+	struct SleepingTask
+	{
+		void operator()()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(sleep));
+			thread = std::this_thread::get_id();
+		}
+
+		int				sleep;
+		std::thread::id	thread;
+	};
+
+	// Dense polynomial, suitable for vector coded multiplication.
+	dpoly densePoly(int const n)
+	{
+		dpoly x(Psym("x")), y(Psym("y")), z(Psym("z")), t(Psym("t"));
+		return (x + y + z + t + 1).pow(n);
+	}
+
+	// Sparse polynomial, multiplied through hash coded multiplication.
+	dpoly sparsePoly(int const n)
+	{
+		dpoly x(Psym("x")), y(Psym("y")), z(Psym("z")), t(Psym("t"));
+		return (x + y.pow(3) + z.pow(17) * x.pow(5) + t.pow(101) + 1).pow(n);
+	}
+
+	// Sparse polynomial in n variables.
+	dpoly manyVariablesPoly(int const n, int const degree)
+	{
+		dpoly retval(1);
+		for (int i = 0; i < n; ++i)
+		{
+			retval += dpoly(Psym("x" + boost::lexical_cast<std::string>(i))).pow(degree);
+		}
+		return retval.pow(2);
+	}
+
+	// Whether the coefficient of the monomial m in p is c.
+	template <class Series>
+	bool hasTerm(Series const &p, Series const &m, double const c)
+	{
+		return (p - m * c).length() + 1 == p.length();
+	}
+
+	// Check densePoly(8) * (densePoly(8) + 1), i.e., s^16 + s^8 with s = x + y + z + t + 1, against its known coefficients.
+	void checkDenseProduct(dpoly const &p)
+	{
+		dpoly const x(Psym("x")), y(Psym("y")), z(Psym("z")), t(Psym("t"));
+		// All the monomials of degree up to 16 in 4 variables.
+		BOOST_TEST(p.length() == 4845u);
+		BOOST_TEST(hasTerm(p, dpoly(1), 2.));
+		BOOST_TEST(hasTerm(p, x.pow(16), 1.));
+		BOOST_TEST(hasTerm(p, x.pow(8), 12871.));
+		BOOST_TEST(hasTerm(p, x * y * z * t, 45360.));
+		BOOST_TEST(hasTerm(p, (x * y * z * t).pow(4), 63063000.));
+	}
+
+	template <class Series>
+	Series multiply(Series const &a, Series const &b, Algorithm const algorithm, unsigned const nthread)
+	{
+		settings::set_nthread(nthread);
+		settings::setMultiplicationAlgorithm(algorithm);
+		Series retval = a * b;
+		settings::setMultiplicationAlgorithm(Algorithm::AUTOMATIC);
+		settings::set_nthread(1);
+
+		return retval;
+	}
+
+	// Real, rational or negative integer power through the given engine.
+	template <class Series, class Number>
+	Series power(Series const &a, Number const &y, settings::PowerAlgorithm const algorithm)
+	{
+		settings::setPowerAlgorithm(algorithm);
+		Series retval = a.pow(y);
+		settings::setPowerAlgorithm(settings::PowerAlgorithm::AUTOMATIC);
+
+		return retval;
+	}
+
+	// Multiply a copy of a by itself, i.e., through coded squaring.
+	template <class Series>
+	Series square(Series const &a, Algorithm const algorithm, unsigned const nthread)
+	{
+		settings::set_nthread(nthread);
+		settings::setMultiplicationAlgorithm(algorithm);
+		Series retval(a);
+		retval *= retval;
+		settings::setMultiplicationAlgorithm(Algorithm::AUTOMATIC);
+		settings::set_nthread(1);
+
+		return retval;
+	}
+
+	void checkConsistency(dpoly const &a, dpoly const &b, Algorithm const algorithm)
+	{
+		dpoly const reference = multiply(a, b, Algorithm::PLAIN, 1);
+		for (unsigned nthread = 1; nthread <= 4; ++nthread)
+		{
+			dpoly const result = multiply(a, b, algorithm, nthread);
+			BOOST_TEST(result.length() == reference.length());
+			BOOST_TEST((result - reference).length() == 0);
+		}
+	}
+
+	// With floating point coefficients and numerical cancellations the order of accumulation matters,
+	// hence only the norm of the difference is checked.
+	void checkConsistency(dfs const &a, dfs const &b, Algorithm const algorithm)
+	{
+		dfs const reference = multiply(a, b, Algorithm::PLAIN, 1);
+		for (unsigned nthread = 1; nthread <= 4; ++nthread)
+		{
+			dfs const result = multiply(a, b, algorithm, nthread);
+			BOOST_TEST((result - reference).norm() <= 1E-12 * reference.norm());
+		}
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(hash_coded_threads)
+{
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(6);
+	checkConsistency(a, a + 1, Algorithm::HASH_CODED);
+	dpoly const b = densePoly(8);
+	checkConsistency(b, b + 1, Algorithm::HASH_CODED);
+
+	// Each task accumulates the products of its own range of codes.
+	std::size_t const threaded = statCount("mult_mt: hash");
+	checkDenseProduct(multiply(b, b + 1, Algorithm::HASH_CODED, 4));
+	BOOST_TEST(statCount("mult_mt: hash") == threaded + 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(poisson_hash_coded_threads)
+{
+	SettingsGuard guard;
+	dfs const elp3("elp3.dfs");
+	checkConsistency(elp3, elp3, Algorithm::HASH_CODED);
+
+	// The cosine and sine products go to separate tables: check them against the product-to-sum formulae,
+	// with threading forced on these small series.
+	settings::MultiplicationThresholds t;
+	t.threadedCoded = 0;
+	settings::setMultiplicationThresholds(t);
+	dps const l(Psym("l"));
+	dps c, s, cc, ss, cs;
+	for (int j = 1; j <= 4; ++j)
+	{
+		c += (l * j).cos();
+		s += (l * j).sin();
+		for (int k = 1; k <= 4; ++k)
+		{
+			dps const cosDifference = (j == k) ? dps(1) : (l * std::abs(j - k)).cos();
+			dps const sinDifference = (j == k) ? dps() : (l * (k - j)).sin();
+			cc += ((l * (j + k)).cos() + cosDifference) * 0.5;
+			ss += (cosDifference - (l * (j + k)).cos()) * 0.5;
+			cs += ((l * (j + k)).sin() + sinDifference) * 0.5;
+		}
+	}
+	std::size_t const threaded = statCount("mult_mt: hash-poisson");
+	BOOST_TEST((multiply(c, c, Algorithm::HASH_CODED, 4) - cc).length() == 0u);
+	BOOST_TEST((multiply(s, s, Algorithm::HASH_CODED, 4) - ss).length() == 0u);
+	BOOST_TEST((multiply(c, s, Algorithm::HASH_CODED, 4) - cs).length() == 0u);
+	BOOST_TEST(statCount("mult_mt: hash-poisson") == threaded + 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(vector_coded_threads)
+{
+	SettingsGuard guard;
+	dpoly const a = densePoly(10);
+	checkConsistency(a, a + 1, Algorithm::VECTOR_CODED);
+	dfs const elp3("elp3.dfs");
+	checkConsistency(elp3, elp3, Algorithm::VECTOR_CODED);
+
+	std::size_t const threaded = statCount("mult_mt: block-polynomial");
+	dpoly const b = densePoly(8);
+	checkDenseProduct(multiply(b, b + 1, Algorithm::VECTOR_CODED, 4));
+	BOOST_TEST(statCount("mult_mt: block-polynomial") == threaded + 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(work_stealing)
+{
+	// The first chunk is slow: the other threads finish their own chunks and steal from it.
+	std::vector<SleepingTask> tasks(64, SleepingTask{0});
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		tasks[i].sleep = 20;
+	}
+	WorkStealingExecutor executor(4);
+	executor.run(tasks);
+	std::set<std::thread::id> threads;
+	for (std::size_t i = 0; i < 16; ++i)
+	{
+		threads.insert(tasks[i].thread);
+	}
+	BOOST_TEST(threads.size() > 1u);
+	for (SleepingTask const &task: tasks)
+	{
+		BOOST_TEST((task.thread != std::thread::id()));
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(plain_threads)
+{
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(4);
+	checkConsistency(a, a + 1, Algorithm::PLAIN);
+
+	// The jobs of the pool multiply disjoint slices of the first series. a * (a + 1) is s^8 + s^4,
+	// with s = x + y^3 + z^17 x^5 + t^101 + 1.
+	std::size_t const threaded = statCount("mult_mt: plain");
+	dpoly const product = multiply(a, a + 1, Algorithm::PLAIN, 4);
+	BOOST_TEST(statCount("mult_mt: plain") == threaded + 1);
+	dpoly const x(Psym("x")), y(Psym("y")), t(Psym("t"));
+	BOOST_TEST(hasTerm(product, dpoly(1), 2.));
+	BOOST_TEST(hasTerm(product, t.pow(808), 1.));
+	BOOST_TEST(hasTerm(product, x.pow(4), 71.));
+	BOOST_TEST(hasTerm(product, y.pow(3) * t.pow(101), 68.));
+
+	// The pool follows the number of threads set in the settings.
+	settings::set_nthread(3);
+	BOOST_TEST(ThreadPool::size() == 3u);
+	BOOST_CHECK_THROW(settings::set_nthread(0), value_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(vector_coded_truncated_threads)
+{
+	SettingsGuard guard;
+	dpoly const a = densePoly(10);
+	dpoly const x(Psym("x")), y(Psym("y")), z(Psym("z")), t(Psym("t"));
+	// a * (a + 1) is s^20 + s^10, with s = x + y + z + t + 1.
+	truncators::Degree::set(14);
+	checkConsistency(a, a + 1, Algorithm::VECTOR_CODED);
+	std::size_t threaded = statCount("mult_mt: block-polynomial");
+	dpoly product = multiply(a, a + 1, Algorithm::VECTOR_CODED, 4);
+	BOOST_TEST(statCount("mult_mt: block-polynomial") == threaded + 1);
+	// All the monomials of degree up to 13 in 4 variables.
+	BOOST_TEST(product.length() == 2380u);
+	BOOST_TEST(hasTerm(product, dpoly(1), 2.));
+	BOOST_TEST(hasTerm(product, x.pow(13), 77520.));
+	BOOST_TEST(hasTerm(product, x.pow(10), 184757.));
+	BOOST_TEST(hasTerm(product, x * y * z * t, 121320.));
+
+	truncators::Degree::set("x", 3);
+	checkConsistency(a, a + 1, Algorithm::VECTOR_CODED);
+	threaded = statCount("mult_mt: block-polynomial");
+	product = multiply(a, a + 1, Algorithm::VECTOR_CODED, 4);
+	BOOST_TEST(statCount("mult_mt: block-polynomial") == threaded + 1);
+	// The monomials of degree up to 20 with x at most squared.
+	BOOST_TEST(product.length() == 4641u);
+	BOOST_TEST(hasTerm(product, x.pow(2) * y.pow(18), 190.));
+	BOOST_TEST(hasTerm(product, y.pow(10), 184757.));
+	truncators::Degree::unset();
+
+	// Only the pairs surviving the truncation count towards threading.
+	truncators::Degree::set(1);
+	std::size_t const threaded = statCount("mult_mt: block-polynomial");
+	multiply(a, a + 1, Algorithm::VECTOR_CODED, 4);
+	BOOST_TEST(statCount("mult_mt: block-polynomial") == threaded);
+	truncators::Degree::unset();
+
+	dfs const elp3("elp3.dfs");
+	truncators::Norm::set(1E-6);
+	checkConsistency(elp3, elp3, Algorithm::VECTOR_CODED);
+	truncators::Norm::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(cache_sizes)
+{
+	SettingsGuard guard;
+	for (unsigned level = 1; level <= settings::cacheLevels; ++level)
+	{
+		BOOST_TEST(settings::get_cache_size(level) > 0u);
+	}
+	BOOST_CHECK_THROW(settings::get_cache_size(0), value_error);
+	BOOST_CHECK_THROW(settings::set_cache_size(4, 1024), value_error);
+	BOOST_CHECK_THROW(settings::set_cache_size(1, 0), value_error);
+
+	// Tiny caches give small blocks at every level, and many tasks in the threaded vector coded multiplication.
+	settings::set_cache_size(1, 1);
+	settings::set_cache_size(2, 4);
+	settings::set_cache_size(3, 64);
+	BOOST_TEST(settings::get_cache_size(2) == 4u);
+	dpoly const a = densePoly(8);
+	checkConsistency(a, a + 1, Algorithm::VECTOR_CODED);
+	checkConsistency(a, a + 1, Algorithm::HASH_CODED);
+	dfs const elp3("elp3.dfs");
+	checkConsistency(elp3, elp3, Algorithm::VECTOR_CODED);
+
+	// The output of the product spans 17^4 codes of 8 bytes. Split so that the output of each task fits into
+	// 4 KB, it needs more than the 8 tasks per thread used for load balancing alone.
+	std::size_t tasks = statCount("mult_mt: tasks");
+	checkDenseProduct(multiply(a, a + 1, Algorithm::VECTOR_CODED, 2));
+	std::size_t const tinyTasks = statCount("mult_mt: tasks") - tasks;
+	BOOST_TEST(tinyTasks > 16u);
+	BOOST_TEST(tinyTasks <= 128u);
+
+	settings::detect_cache_sizes();
+	BOOST_TEST(settings::get_cache_size(2) != 4u);
+	tasks = statCount("mult_mt: tasks");
+	checkDenseProduct(multiply(a, a + 1, Algorithm::VECTOR_CODED, 2));
+	BOOST_TEST(statCount("mult_mt: tasks") - tasks <= 16u);
+}
+
+
+BOOST_AUTO_TEST_CASE(wide_hash_coded_threads)
+{
+	SettingsGuard guard;
+	// a * (a + 1) is (1 + S)^4 + (1 + S)^2, with S the sum of x0^25 ... x9^25. Each exponent of the product
+	// ranges over [0, 100], and 101^10 codes do not fit into 64 bits.
+	dpoly const a = manyVariablesPoly(10, 25);
+	checkConsistency(a, a + 1, Algorithm::HASH_CODED);
+	std::size_t const wide = statCount("mult_coded_wide");
+	dpoly const product = multiply(a, a + 1, Algorithm::HASH_CODED, 2);
+	BOOST_TEST(statCount("mult_coded_wide") == wide + 1);
+	dpoly const x0(Psym("x0")), x1(Psym("x1")), x2(Psym("x2")), x3(Psym("x3"));
+	// All the products of up to 4 of the x_i^25.
+	BOOST_TEST(product.length() == 1001u);
+	BOOST_TEST(hasTerm(product, dpoly(1), 2.));
+	BOOST_TEST(hasTerm(product, x0.pow(100), 1.));
+	BOOST_TEST(hasTerm(product, x0.pow(25), 6.));
+	BOOST_TEST(hasTerm(product, x0.pow(50), 7.));
+	BOOST_TEST(hasTerm(product, (x0 * x1).pow(25), 14.));
+	BOOST_TEST(hasTerm(product, (x0 * x1 * x2 * x3).pow(25), 24.));
+	// There is no vector coded multiplication for the wide codes.
+	settings::setMultiplicationAlgorithm(Algorithm::VECTOR_CODED);
+	BOOST_CHECK_THROW(a * (a + 1), value_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(split_coded_threads)
+{
+	SettingsGuard guard;
+	// a * (a + 1) is (1 + S)^4 + (1 + S)^2, with S the sum of x0^10 ... x24^10. Each exponent of the product
+	// ranges over [0, 40], and 41^25 codes do not even fit into 128 bits.
+	dpoly const a = manyVariablesPoly(25, 10);
+	dpoly const x0(Psym("x0")), x1(Psym("x1")), x2(Psym("x2")), x3(Psym("x3"));
+	checkConsistency(a, a + 1, Algorithm::HASH_CODED);
+	std::size_t const split = statCount("mult_coded_split");
+	dpoly product = multiply(a, a + 1, Algorithm::HASH_CODED, 1);
+	BOOST_TEST(statCount("mult_coded_split") == split + 1);
+	// All the products of up to 4 of the x_i^10.
+	BOOST_TEST(product.length() == 23751u);
+	BOOST_TEST(hasTerm(product, dpoly(1), 2.));
+	BOOST_TEST(hasTerm(product, x0.pow(40), 1.));
+	BOOST_TEST(hasTerm(product, x0.pow(10), 6.));
+	BOOST_TEST(hasTerm(product, x0.pow(20), 7.));
+	BOOST_TEST(hasTerm(product, (x0 * x1).pow(10), 14.));
+	BOOST_TEST(hasTerm(product, (x0 * x1 * x2 * x3).pow(10), 24.));
+
+	// Only the products of up to 2 of the x_i^10 are below degree 30.
+	truncators::Degree::set(30);
+	checkConsistency(a, a + 1, Algorithm::HASH_CODED);
+	product = multiply(a, a + 1, Algorithm::HASH_CODED, 1);
+	BOOST_TEST(product.length() == 351u);
+	BOOST_TEST(hasTerm(product, dpoly(1), 2.));
+	BOOST_TEST(hasTerm(product, x0.pow(20), 7.));
+	BOOST_TEST(hasTerm(product, (x0 * x1).pow(10), 14.));
+	truncators::Degree::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(heap_coded)
+{
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(6);
+	checkConsistency(a, a + 1, Algorithm::HEAP_CODED);
+
+	// Every pair leaves the heap once, and the products come out in code order: all the products
+	// of a code are extracted together, hence there are as many distinct codes as terms in the result.
+	std::size_t const pairs = statCount("mult_st: heap pairs");
+	std::size_t const codes = statCount("mult_st: heap codes");
+	dpoly const product = multiply(a, a + 1, Algorithm::HEAP_CODED, 1);
+	BOOST_TEST(statCount("mult_st: heap pairs") - pairs == a.length() * (a + 1).length());
+	BOOST_TEST(statCount("mult_st: heap codes") - codes == product.length());
+
+	truncators::Degree::set(20);
+	checkConsistency(a, a + 1, Algorithm::HEAP_CODED);
+	truncators::Degree::unset();
+	dpoly const b = manyVariablesPoly(10, 25);
+	checkConsistency(b, b + 1, Algorithm::HEAP_CODED);
+
+	// Neither split codes nor Poisson series can be merged through the heap.
+	settings::setMultiplicationAlgorithm(Algorithm::HEAP_CODED);
+	dpoly const c = manyVariablesPoly(25, 10);
+	BOOST_CHECK_THROW(c * (c + 1), value_error);
+	dfs const elp3("elp3.dfs");
+	BOOST_CHECK_THROW(elp3 * elp3, value_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(multiplication_thresholds)
+{
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(4);
+	dpoly const reference = multiply(a, a + 1, Algorithm::PLAIN, 1);
+
+	// Coded multiplication only above an unreachable size.
+	settings::MultiplicationThresholds t;
+	t.plainCoded = 1E12;
+	settings::setMultiplicationThresholds(t);
+	std::size_t const plain = statCount("multiplication_plain");
+	BOOST_TEST((a * (a + 1) - reference).length() == 0);
+	BOOST_TEST(statCount("multiplication_plain") == plain + 1);
+
+	// The override applies only to its scope.
+	{
+		settings::MultiplicationThresholds o;
+		o.plainCoded = 0;
+		settings::MultiplicationThresholdsOverride const override(o);
+		BOOST_TEST(settings::getMultiplicationThresholds().plainCoded == 0.);
+		BOOST_TEST((a * (a + 1) - reference).length() == 0);
+		BOOST_TEST(statCount("multiplication_plain") == plain + 1);
+
+		// The pool threads see the override while running the tasks.
+		std::vector<ThresholdsTask> tasks(16, ThresholdsTask{1});
+		WorkStealingExecutor executor(4);
+		executor.run(tasks);
+		for (ThresholdsTask const &task: tasks)
+		{
+			BOOST_TEST(task.plainCoded == 0.);
+		}
+	}
+	BOOST_TEST(settings::getMultiplicationThresholds().plainCoded == 1E12);
+
+	// Profile round trip.
+	std::string const profile = (std::filesystem::temp_directory_path() / "piranha_test_multiplication.profile").string();
+	t.sparseDensity = 1.0 / 3.0;
+	t.threadedCoded = 123;
+	settings::setMultiplicationThresholds(t);
+	settings::saveMultiplicationProfile(profile);
+	settings::setMultiplicationThresholds(settings::MultiplicationThresholds());
+	settings::loadMultiplicationProfile(profile);
+	BOOST_TEST(settings::getMultiplicationThresholds().plainCoded == t.plainCoded);
+	BOOST_TEST(settings::getMultiplicationThresholds().sparseDensity == t.sparseDensity);
+	BOOST_TEST(settings::getMultiplicationThresholds().threadedCoded == t.threadedCoded);
+	BOOST_TEST(settings::getMultiplicationThresholds().threadedPlain == t.threadedPlain);
+	BOOST_CHECK_THROW(settings::loadMultiplicationProfile("no_such.profile"), value_error);
+	t.sparseDensity = 0;
+	BOOST_CHECK_THROW(settings::setMultiplicationThresholds(t), value_error);
+
+	// Calibration sets the global thresholds and saves them.
+	settings::MultiplicationThresholds const c = calibrateMultiplication<dpoly>(profile, true);
+	BOOST_TEST(settings::getMultiplicationThresholds().plainCoded == c.plainCoded);
+	BOOST_TEST(settings::getMultiplicationThresholds().sparseDensity == c.sparseDensity);
+	BOOST_TEST(c.sparseDensity > 0.);
+	BOOST_TEST((a * (a + 1) - reference).length() == 0);
+	settings::setMultiplicationThresholds(settings::MultiplicationThresholds());
+	settings::loadMultiplicationProfile(profile);
+	BOOST_TEST(settings::getMultiplicationThresholds().plainCoded == c.plainCoded);
+	std::filesystem::remove(profile);
+}
+
+
+BOOST_AUTO_TEST_CASE(fft_coded)
+{
+	SettingsGuard guard;
+	// Dense polynomial with coefficients of similar magnitude, so that the FFT is accurate enough.
+	dpoly const x(Psym("x")), y(Psym("y"));
+	dpoly a, b;
+	for (int i = 0; i < 30; ++i)
+	{
+		for (int j = 0; j < 30; ++j)
+		{
+			a += x.pow(i) * y.pow(j) * (1 + ((7 * i + 13 * j) % 10) / 10.);
+			b += x.pow(i) * y.pow(j) * (1 + ((3 * i + 11 * j) % 10) / 10.);
+		}
+	}
+	dpoly const reference = multiply(a, b, Algorithm::PLAIN, 1);
+
+	settings::MultiplicationThresholds t;
+	t.fftCost = 0;
+	settings::setMultiplicationThresholds(t);
+	std::size_t const fft = statCount("mult_st: fft");
+	dpoly const result = multiply(a, b, Algorithm::FFT, 1);
+	BOOST_TEST(statCount("mult_st: fft") == fft + 1);
+	BOOST_TEST(result.length() == reference.length());
+	BOOST_TEST((result - reference).norm() <= 1E-12 * reference.norm());
+
+	// No FFT under truncation, nor unless it is selected.
+	settings::setMultiplicationAlgorithm(Algorithm::FFT);
+	truncators::Degree::set(40);
+	dpoly const truncated = a * b;
+	truncators::Degree::unset();
+	settings::setMultiplicationAlgorithm(Algorithm::AUTOMATIC);
+	BOOST_TEST(statCount("mult_st: fft") == fft + 1);
+	BOOST_TEST(truncated.length() < reference.length());
+	dpoly const automatic = a * b;
+	multiply(a, b, Algorithm::VECTOR_CODED, 1);
+	BOOST_TEST(statCount("mult_st: fft") == fft + 1);
+	BOOST_TEST(automatic.length() == reference.length());
+}
+
+
+BOOST_AUTO_TEST_CASE(coded_squaring)
+{
+	SettingsGuard guard;
+	dpoly const dense = densePoly(6), sparse = sparsePoly(5);
+	dpoly const dense2 = multiply(dense, dense, Algorithm::PLAIN, 1);
+	dpoly const sparse2 = multiply(sparse, sparse, Algorithm::PLAIN, 1);
+	for (unsigned nthread = 1; nthread <= 4; ++nthread)
+	{
+		std::size_t const squarings = statCount("mult_square");
+		BOOST_TEST((square(dense, Algorithm::VECTOR_CODED, nthread) - dense2).length() == 0);
+		BOOST_TEST((square(sparse, Algorithm::HASH_CODED, nthread) - sparse2).length() == 0);
+		BOOST_TEST(statCount("mult_square") == squarings + 2);
+	}
+
+	// Equal, but distinct, operands are multiplied as usual.
+	std::size_t const squarings = statCount("mult_square");
+	multiply(sparse, sparse, Algorithm::HASH_CODED, 1);
+	BOOST_TEST(statCount("mult_square") == squarings);
+
+	// Truncated squaring.
+	truncators::Degree::set(9);
+	dpoly const truncated = multiply(dense, dense, Algorithm::PLAIN, 1);
+	BOOST_TEST(truncated.length() < dense2.length());
+	BOOST_TEST((square(dense, Algorithm::VECTOR_CODED, 1) - truncated).length() == 0);
+	BOOST_TEST((square(dense, Algorithm::HASH_CODED, 3) - truncated).length() == 0);
+	truncators::Degree::unset();
+
+	// Poisson series: the products of (i, j) and (j, i) agree once canonicalised.
+	dps const e(Psym("e")), l(Psym("l")), m(Psym("m"));
+	dps const c = (e * l.cos() + l.sin() * m.cos() * 2 + m.sin() + 1).pow(3);
+	dps const c2 = multiply(c, c, Algorithm::PLAIN, 1);
+	for (unsigned nthread = 1; nthread <= 4; nthread += 3)
+	{
+		std::size_t const poissonSquarings = statCount("mult_square");
+		BOOST_TEST((square(c, Algorithm::VECTOR_CODED, nthread) - c2).norm() <= 1E-12 * c2.norm());
+		BOOST_TEST((square(c, Algorithm::HASH_CODED, nthread) - c2).norm() <= 1E-12 * c2.norm());
+		BOOST_TEST(statCount("mult_square") == poissonSquarings + 2);
+	}
+
+	// Exponentiation squares the intermediate results.
+	settings::setMultiplicationAlgorithm(Algorithm::PLAIN);
+	dpoly const reference = sparse.pow(5);
+	settings::setMultiplicationAlgorithm(Algorithm::AUTOMATIC);
+	BOOST_TEST((sparse.pow(5) - reference).length() == 0);
+	BOOST_TEST(statCount("mult_square") > squarings);
+}
+
+
+BOOST_AUTO_TEST_CASE(addmul)
+{
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(4), b = sparsePoly(3) + dpoly(Psym("x")) * 3;
+	dpoly const r = densePoly(4);
+	dpoly const reference = r + multiply(a, b, Algorithm::PLAIN, 1);
+	Algorithm const algorithms[] = {Algorithm::PLAIN, Algorithm::VECTOR_CODED, Algorithm::HASH_CODED, Algorithm::HEAP_CODED};
+	for (Algorithm const algorithm: algorithms)
+	{
+		for (unsigned nthread = 1; nthread <= 4; ++nthread)
+		{
+			settings::set_nthread(nthread);
+			settings::setMultiplicationAlgorithm(algorithm);
+			dpoly result(r);
+			result.addmul(a, b);
+			settings::setMultiplicationAlgorithm(Algorithm::AUTOMATIC);
+			BOOST_TEST(result.length() == reference.length());
+			BOOST_TEST((result - reference).length() == 0);
+		}
+	}
+	settings::set_nthread(1);
+
+	// Terms cancelling out, aliasing and arguments missing from the accumulator.
+	dpoly cancel(1 - a * b);
+	cancel.addmul(a, b);
+	BOOST_TEST((cancel - 1).length() == 0);
+	dpoly self(a);
+	self.addmul(self, b);
+	BOOST_TEST((self - (a + a * b)).length() == 0);
+	dpoly const y(Psym("y")), u(Psym("u"));
+	dpoly other(u + 1);
+	other.addmul(y, a);
+	BOOST_TEST((other - (u + 1 + y * a)).length() == 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(truncated_row_ends)
+{
+	// Heap coded multiplication checks every pair against the truncator, hence it is the reference.
+	SettingsGuard guard;
+	dpoly const a = densePoly(8), b = sparsePoly(3);
+	dpoly const full = a * b;
+	for (int partial = 0; partial < 2; ++partial)
+	{
+		if (partial)
+		{
+			truncators::Degree::set("x", 5);
+		} else
+		{
+			truncators::Degree::set(12);
+		}
+		dpoly const reference = multiply(a, b, Algorithm::HEAP_CODED, 1);
+		dpoly const squareReference = multiply(a, a, Algorithm::HEAP_CODED, 1);
+		BOOST_TEST(reference.length() < full.length());
+		Algorithm const algorithms[] = {Algorithm::PLAIN, Algorithm::VECTOR_CODED, Algorithm::HASH_CODED};
+		for (Algorithm const algorithm: algorithms)
+		{
+			BOOST_TEST((multiply(a, b, algorithm, 1) - reference).length() == 0);
+			BOOST_TEST((square(a, algorithm, 1) - squareReference).length() == 0);
+		}
+	}
+
+	// (1 + x + ... + x^20)^2 below degree 12: row i ends at column 12 - i, and x^k is reached k + 1 times.
+	dpoly const x(Psym("x"));
+	dpoly u;
+	for (int i = 0; i <= 20; ++i)
+	{
+		u += x.pow(i);
+	}
+	dpoly const v(u);
+	truncators::Degree::set(12);
+	Algorithm const algorithms[] = {Algorithm::PLAIN, Algorithm::VECTOR_CODED, Algorithm::HASH_CODED, Algorithm::HEAP_CODED};
+	for (Algorithm const algorithm: algorithms)
+	{
+		dpoly const product = multiply(u, v, algorithm, 1);
+		BOOST_TEST(product.length() == 12u);
+		for (int k = 0; k < 12; ++k)
+		{
+			BOOST_TEST(hasTerm(product, x.pow(k), k + 1.));
+		}
+		if (algorithm != Algorithm::HEAP_CODED)
+		{
+			BOOST_TEST((square(u, algorithm, 1) - product).length() == 0);
+		}
+	}
+	truncators::Degree::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(degree_truncator_rational_limit)
+{
+	// The precomputed degrees are integers: a limit of 23/2 must truncate like a limit of 12.
+	SettingsGuard guard;
+	dpoly const a = densePoly(8), b = sparsePoly(3);
+	truncators::Degree::set(12);
+	dpoly const reference = multiply(a, b, Algorithm::HEAP_CODED, 1);
+	truncators::Degree::set(mp_rational(23, 2));
+	Algorithm const algorithms[] = {Algorithm::PLAIN, Algorithm::VECTOR_CODED, Algorithm::HASH_CODED, Algorithm::HEAP_CODED};
+	for (Algorithm const algorithm: algorithms)
+	{
+		BOOST_TEST((multiply(a, b, algorithm, 1) - reference).length() == 0);
+	}
+
+	// (1 + x + ... + x^20)^2 keeps the terms of degree below the limit, i.e., up to x^11 for 23/2 and x^12 for 25/2.
+	dpoly const x(Psym("x"));
+	dpoly u;
+	for (int i = 0; i <= 20; ++i)
+	{
+		u += x.pow(i);
+	}
+	dpoly const v(u);
+	for (Algorithm const algorithm: algorithms)
+	{
+		truncators::Degree::set(mp_rational(23, 2));
+		dpoly product = multiply(u, v, algorithm, 1);
+		BOOST_TEST(product.length() == 12u);
+		BOOST_TEST(hasTerm(product, x.pow(11), 12.));
+		truncators::Degree::set(mp_rational(25, 2));
+		product = multiply(u, v, algorithm, 1);
+		BOOST_TEST(product.length() == 13u);
+		BOOST_TEST(hasTerm(product, x.pow(12), 13.));
+	}
+	truncators::Degree::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(pairwise_norm_truncation)
+{
+	SettingsGuard guard;
+	dfs const elp3("elp3.dfs");
+	dfs const full = multiply(elp3, elp3, Algorithm::PLAIN, 1);
+	// Norms of the terms, the trigonometric parts having unit norm.
+	std::vector<double> norms;
+	for (auto const &term: elp3)
+	{
+		norms.push_back(std::abs(term.cf.get_value()));
+	}
+	double const smallest = *std::min_element(norms.begin(), norms.end());
+	double const largest  = *std::max_element(norms.begin(), norms.end());
+
+	// No product is below the norm of the smallest one, and all of them are below twice the largest one.
+	truncators::Norm::setPairwise(smallest * smallest);
+	BOOST_TEST((multiply(elp3, elp3, Algorithm::PLAIN, 1) - full).norm() <= 1E-12 * full.norm());
+	truncators::Norm::setPairwise(2 * largest * largest);
+	BOOST_TEST(multiply(elp3, elp3, Algorithm::PLAIN, 1).length() == 0u);
+
+	// The discarded part of the product is made of the products of terms whose norm is below the truncation level.
+	double const level = 1E-6;
+	double discarded = 0;
+	for (double const norm1: norms)
+	{
+		for (double const norm2: norms)
+		{
+			if (norm1 * norm2 < level)
+			{
+				discarded += norm1 * norm2;
+			}
+		}
+	}
+	truncators::Norm::setPairwise(level);
+	dfs const reference = multiply(elp3, elp3, Algorithm::PLAIN, 1);
+	BOOST_TEST(reference.length() < full.length());
+	BOOST_TEST((full - reference).norm() <= discarded + 1E-12 * full.norm());
+	Algorithm const algorithms[] = {Algorithm::VECTOR_CODED, Algorithm::HASH_CODED};
+	for (Algorithm const algorithm: algorithms)
+	{
+		checkConsistency(elp3, elp3, algorithm);
+	}
+	truncators::Norm::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(truncated_natural_power)
+{
+	SettingsGuard guard;
+	dpoly const x(Psym("x")), y(Psym("y"));
+	dpoly const base = x + y + 1;
+	truncators::Degree::set(6);
+	stats::set("pow: peak terms", "0");
+	for (int n = 0; n <= 13; ++n)
+	{
+		// Repeated multiplication by the base, truncated at every step.
+		dpoly reference(1);
+		for (int i = 0; i < n; ++i)
+		{
+			reference *= base;
+		}
+		BOOST_TEST((base.pow(n) - reference).length() == 0);
+	}
+	// Terms of degree 6 and higher never appear in the intermediate results: at most 1 + 2 + ... + 6 terms remain.
+	BOOST_TEST(statCount("pow: peak terms") == 21);
+
+	// All the terms are truncated at the first squaring, and the result stays empty.
+	BOOST_TEST((x * y + x).pow(13).length() == 0);
+	truncators::Degree::unset();
+}
+
+
+BOOST_AUTO_TEST_CASE(miller_power)
+{
+	SettingsGuard guard;
+	qpoly const x(Psym("x")), y(Psym("y"));
+	qpoly const a = 4 + x + x * y * y - 3 * x * x * y;
+	mp_rational const exponents[] = {mp_rational(1, 2), mp_rational(-3, 2), mp_rational(-2), mp_rational(5, 2)};
+	for (int partial = 0; partial < 2; ++partial)
+	{
+		if (partial)
+		{
+			truncators::Degree::set("x", 7);
+		} else
+		{
+			truncators::Degree::set(9);
+		}
+
+		for (mp_rational const &q: exponents)
+		{
+			qpoly const reference = power(a, q, settings::PowerAlgorithm::BINOMIAL);
+			qpoly const result = power(a, q, settings::PowerAlgorithm::MILLER);
+			BOOST_TEST(result.length() > 0);
+			BOOST_TEST((result - reference).length() == 0);
+		}
+
+		// The truncated square of the square root is the original polynomial.
+		qpoly const root = power(a, mp_rational(1, 2), settings::PowerAlgorithm::MILLER);
+		BOOST_TEST((root * root - a).length() == 0);
+	}
+
+	// The Miller recurrence needs the grading of the degree truncator.
+	truncators::Degree::unset();
+	BOOST_CHECK_THROW(power(a, mp_rational(1, 2), settings::PowerAlgorithm::MILLER), value_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(hash_coded_arena)
+{
+	// The hash tables of hash coded multiplication live in an arena owned by the multiplication.
+	SettingsGuard guard;
+	dpoly const a = sparsePoly(6);
+	dpoly const product = multiply(a, a + 1, Algorithm::HASH_CODED, 1);
+	std::size_t const used = settings::get_used_memory();
+	BOOST_TEST((multiply(a, a + 1, Algorithm::HASH_CODED, 4) - product).length() == 0u);
+	BOOST_TEST(settings::get_used_memory() == used);
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2007, 2008 by Francesco Biscani   *
+ *   bluescarni@gmail.com   *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program; if not, write to the                         *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "piranha.h"
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Scaling of the memory accounting of CountingAllocator with the number of threads.
+// Each thread allocates and frees small blocks, the size of the key vectors and GMP temporaries
+// of a multiplication, through:
+// - a reference allocator updating one shared atomic counter and reading the memory limit at every allocation;
+// - CountingAllocator, batching the updates through per-thread balances.
+
+using namespace piranha;
+
+namespace {
+
+	std::atomic<std::size_t> sharedCounter(0);
+
+	// Counting on a shared atomic at every allocation and deallocation.
+	template <class T>
+	struct SharedCountingAllocator
+	{
+		typedef T value_type;
+
+		SharedCountingAllocator() = default;
+
+		template <class U>
+		SharedCountingAllocator(SharedCountingAllocator<U> const &) {}
+
+		T *allocate(std::size_t const n)
+		{
+			const std::size_t add = n * sizeof(T);
+			if (add > settings::get_memory_limit() || sharedCounter > settings::get_memory_limit() - add)
+			{
+				PIRANHA_THROW(memory_error, "memory limit reached");
+			}
+			sharedCounter += add;
+			return std::allocator<T>().allocate(n);
+		}
+
+		void deallocate(T *const p, std::size_t const n)
+		{
+			std::allocator<T>().deallocate(p, n);
+			sharedCounter -= n * sizeof(T);
+		}
+	};
+
+	std::size_t const blocks = 64;
+	std::size_t const rounds = 20000;
+
+	template <class Allocator>
+	void work()
+	{
+		Allocator allocator;
+		std::vector<char *> p(blocks);
+		for (std::size_t r = 0; r < rounds; ++r)
+		{
+			for (std::size_t i = 0; i < blocks; ++i)
+			{
+				p[i] = allocator.allocate(16 + 8 * (i % 4));
+				p[i][0] = char(i);
+			}
+			for (std::size_t i = 0; i < blocks; ++i)
+			{
+				allocator.deallocate(p[i], 16 + 8 * (i % 4));
+			}
+		}
+		// The balance of the thread is added to the shared counter when the thread exits.
+	}
+
+	// Nanoseconds per allocation with nthread threads.
+	template <class Allocator>
+	double timeAllocations(unsigned const nthread)
+	{
+		const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		boost::thread_group threads;
+		for (unsigned i = 0; i < nthread; ++i)
+		{
+			threads.create_thread(&work<Allocator>);
+		}
+		threads.join_all();
+		const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - t0;
+
+		return elapsed.count() / double(blocks * rounds);
+	}
+}
+
+int main()
+{
+	const std::size_t before = settings::get_used_memory();
+	const unsigned maxThreads = std::max(2u, boost::thread::hardware_concurrency());
+
+	std::cout << "threads  shared (ns/alloc)  batched (ns/alloc)   ratio\n";
+	for (unsigned nthread = 1; nthread <= maxThreads; nthread *= 2)
+	{
+		const double shared  = timeAllocations<SharedCountingAllocator<char> >(nthread);
+		const double batched = timeAllocations<CountingAllocator<char> >(nthread);
+		std::cout << std::setw(7) << nthread << std::setw(19) << shared << std::setw(20) << batched
+				  << std::setw(8) << shared / batched << std::endl;
+	}
+
+	// The balances of the threads are all back into the shared counter.
+	int retval = settings::get_used_memory() != before || sharedCounter != 0;
+	std::cout << "used memory: " << settings::get_used_memory() << " (before: " << before << ")" << std::endl;
+	std::cout << "retval: " << retval << std::endl;
+	return retval;
+}
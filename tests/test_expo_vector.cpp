@@ -13,7 +13,7 @@ using namespace boost::unit_test;
 
 namespace {
 
-	using KeyType = ExpoVector<short int, 0>;// 0 is the position of the key i.e. echelon level
+	using KeyType = ExpoVector<short int, 0, 8>;// 0 is the position of the key i.e. echelon level, 8 exponents are stored inline as in qpoly
 	using KeyRational = ExpoVector<mp_rational, 0>; // rational exponents are possible. when are they actually really used?
 }
 
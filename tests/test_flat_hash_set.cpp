@@ -0,0 +1,87 @@
+#define BOOST_TEST_MODULE Flat hash set Test
+#include "boost/test/included/unit_test.hpp"
+
+#include "piranha.h"
+
+#include <iterator>
+
+using namespace piranha;
+using namespace piranha::manipulators;
+
+
+BOOST_AUTO_TEST_CASE(insert_erase_find)
+{
+	FlatHashSet<int> set;
+	for (int i = 0; i < 1000; ++i)
+	{
+		BOOST_TEST(set.insert(i).second);
+	}
+	BOOST_TEST(!set.insert(42).second);
+
+	// Erasing leaves tombstones, which must not break the lookups of the following keys.
+	for (int i = 0; i < 1000; i += 2)
+	{
+		BOOST_TEST(set.erase(i) == 1u);
+	}
+	BOOST_TEST(set.size() == 500u);
+	for (int i = 0; i < 1000; ++i)
+	{
+		BOOST_TEST((set.find(i) != set.end()) == (i % 2 == 1));
+	}
+	BOOST_TEST(std::distance(set.begin(), set.end()) == 500);
+}
+
+
+BOOST_AUTO_TEST_CASE(insert_unique)
+{
+	FlatHashSet<int> set;
+	for (int i = 0; i < 1000; ++i)
+	{
+		BOOST_TEST(*set.insertUnique(i) == i);
+	}
+	BOOST_TEST(set.size() == 1000u);
+
+	// Tombstones along the probe sequences are reused without looking further.
+	for (int i = 0; i < 1000; i += 2)
+	{
+		set.erase(i);
+	}
+	for (int i = 1000; i < 1500; ++i)
+	{
+		set.insertUnique(i);
+	}
+	BOOST_TEST(set.size() == 1000u);
+	for (int i = 0; i < 1500; ++i)
+	{
+		BOOST_TEST((set.find(i) != set.end()) == (i >= 1000 || i % 2 == 1));
+	}
+	BOOST_TEST(!set.insert(1001).second);
+}
+
+
+BOOST_AUTO_TEST_CASE(copy_clear)
+{
+	FlatHashSet<int> set;
+	for (int i = 1; i < 1000; i += 2)
+	{
+		set.insert(i);
+	}
+
+	FlatHashSet<int> copy(set);
+	set.clear();
+	BOOST_TEST(set.empty());
+	BOOST_TEST((set.begin() == set.end()));
+	BOOST_TEST(copy.size() == 500u);
+	BOOST_TEST((copy.find(999) != copy.end()));
+}
+
+
+BOOST_AUTO_TEST_CASE(series_terms)
+{
+	// Series terms live in the flat set: inserting and cancelling terms goes through erasure.
+	dpoly const x(Psym("x")), y(Psym("y"));
+	dpoly p = (x + y).pow(20);
+	p -= x.pow(20);
+	BOOST_TEST(p.length() == 20u);
+	BOOST_TEST((p - (x + y).pow(20) + x.pow(20)).length() == 0u);
+}
@@ -13,10 +13,10 @@ namespace utf = boost::unit_test;
 namespace {
 	// create a derived type to test the vector_key
 
-	template < class T, int Position>
-	class Intermediate : public VectorKey < T, Position, Intermediate<T, Position>>
+	template < class T, int Position, std::size_t InlineSize = 0>
+	class Intermediate : public VectorKey < T, Position, Intermediate<T, Position, InlineSize>, InlineSize>
 	{
-		using Ancestor = VectorKey < T, Position, Intermediate<T, Position>>;
+		using Ancestor = VectorKey < T, Position, Intermediate<T, Position, InlineSize>, InlineSize>;
 	public:
 		Intermediate() = default;
 		Intermediate(Intermediate const &) = default;
@@ -41,6 +41,7 @@ namespace {
 
 	using KeyType = Intermediate<int, 0>;
 	using KeyType1 = Intermediate<int, 1>;
+	using InlineKeyType = Intermediate<int, 0, 4>;
 }
 
 void setup() { PsymManager::clear(); }
@@ -552,3 +553,46 @@ BOOST_AUTO_TEST_CASE(elementsHasher, *utf::fixture(&setup))
 	BOOST_CHECK_NO_THROW(temp.pelementsHasher());
 }
 
+
+BOOST_AUTO_TEST_CASE(inline_storage, *utf::fixture(&setup))
+{
+	// Keys up to the inline size and keys spilled to the heap behave the same.
+	for (std::size_t size: {std::size_t(3), std::size_t(9)})
+	{
+		InlineKeyType key;
+		key.resize(size);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			key[i] = static_cast<int>(i) - 2;
+		}
+
+		InlineKeyType copy(key);
+		BOOST_TEST((copy == key));
+		BOOST_TEST(copy.pelementsHasher() == key.pelementsHasher());
+
+		InlineKeyType moved(std::move(copy));
+		BOOST_TEST((moved == key));
+		BOOST_TEST(copy.size() == 0);
+
+		// Swap an inline key with a key of the given size.
+		InlineKeyType other;
+		other.resize(2);
+		other[1] = 7;
+		other.swap(moved);
+		BOOST_TEST((other == key));
+		BOOST_TEST(moved.size() == 2);
+		BOOST_TEST(moved[1] == 7);
+
+		// Assignment over a longer and over a shorter key.
+		moved = key;
+		BOOST_TEST((moved == key));
+		moved.resize(12);
+		moved = other;
+		BOOST_TEST((moved == key));
+
+		// Growing keeps the elements and zero fills.
+		moved.resize(size + 4);
+		BOOST_TEST(moved[size - 1] == static_cast<int>(size) - 3);
+		BOOST_TEST(moved[size + 3] == 0);
+	}
+}